@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <linux/mempolicy.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "affinity.hpp"
+
+unsigned numaNodeCount() {
+    unsigned count = 0;
+    struct stat st;
+
+    while (stat(("/sys/devices/system/node/node" + std::to_string(count)).c_str(), &st) == 0) {
+        ++count;
+    }
+
+    return count ? count : 1;
+}
+
+bool numaNodeCpus(const unsigned node, cpu_set_t& cpus) {
+    std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string range;
+
+    if (!cpulist) {
+        return false;
+    }
+
+    CPU_ZERO(&cpus);
+
+    //the format is a comma separated list of CPUs and CPU ranges, e.g. 0-3,8-11
+    while (std::getline(cpulist, range, ',')) {
+        size_t dash = range.find('-');
+        unsigned first = std::stoul(range);
+        unsigned last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+
+        for (unsigned cpu = first; cpu <= last; ++cpu) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+
+    return CPU_COUNT(&cpus) > 0;
+}
+
+unsigned allowedCpuCount() {
+    cpu_set_t current;
+
+    if (sched_getaffinity(0, sizeof(current), &current) == 0 && CPU_COUNT(&current) > 0) {
+        return CPU_COUNT(&current);
+    }
+
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+std::vector<unsigned> allowedNumaNodes() {
+    const unsigned nodes = numaNodeCount();
+    std::vector<unsigned> allowed;
+    cpu_set_t current, cpus;
+
+    if (sched_getaffinity(0, sizeof(current), &current) < 0) {
+        perror("sched_getaffinity");
+        CPU_ZERO(&current);
+    }
+
+    for (unsigned node = 0; node < nodes; ++node) {
+        if (numaNodeCpus(node, cpus)) {
+            CPU_AND(&cpus, &cpus, &current);
+
+            if (CPU_COUNT(&cpus) > 0) {
+                allowed.push_back(node);
+            }
+        }
+    }
+
+    //without sysfs every CPU counts as node 0
+    if (allowed.empty()) {
+        allowed.push_back(0);
+    }
+
+    return allowed;
+}
+
+bool pinToNumaNode(const unsigned node) {
+    cpu_set_t cpus, current;
+
+    if (!numaNodeCpus(node, cpus)) {
+        return false;
+    }
+
+    if (sched_getaffinity(0, sizeof(current), &current) == 0) {
+        CPU_AND(&cpus, &cpus, &current);
+    }
+
+    if (CPU_COUNT(&cpus) == 0) {
+        return false;
+    }
+
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+        perror("sched_setaffinity");
+        return false;
+    }
+
+    return true;
+}
+
+bool interleaveAllocations(const bool interleave) {
+    const unsigned nodes = numaNodeCount();
+    std::vector<unsigned long> mask((nodes + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long)), 0);
+
+    for (unsigned node = 0; node < nodes; ++node) {
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+    }
+
+    long result = interleave ? syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, mask.data(), nodes + 1)
+        : syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+
+    return result == 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <sched.h>
+#include <vector>
+
+// Number of NUMA nodes reported by the kernel, at least 1.
+unsigned numaNodeCount();
+
+// CPUs belonging to a NUMA node. Returns false if the node's CPU list cannot be read.
+bool numaNodeCpus(const unsigned node, cpu_set_t& cpus);
+
+// Number of CPUs the calling thread may run on, falling back to std::thread::hardware_concurrency(), at least 1.
+unsigned allowedCpuCount();
+
+// NUMA nodes with at least one CPU the calling thread may run on, so an already pinned process only sees its own.
+std::vector<unsigned> allowedNumaNodes();
+
+// Restricts the calling thread (and the threads and processes it creates afterwards) to those CPUs of a NUMA node
+// it may already run on. Memory is then allocated on that node by the kernel's first-touch policy.
+bool pinToNumaNode(const unsigned node);
+
+// Where received graphs are placed: wherever the reading thread runs, on the node of the worker computing
+// the request (copied there if needed), or interleaved page by page across all nodes.
+enum class memoryPlacement { firstTouch, local, interleave };
+
+// Makes the calling thread's future allocations interleave across all NUMA nodes, or restores the default policy.
+// Returns false without printing anything if the kernel or container does not allow it.
+bool interleaveAllocations(const bool interleave);
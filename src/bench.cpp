@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include "relax.hpp"
+#include "yen.hpp"
+
+// Compares the filtered adjacency-list Dijkstra with the CSR kernels (scalar, AVX2 on every edge block and
+// AVX2 on blocks of at least the given degree) on a random graph with a few high-degree hubs and 1% banned vertices.
+// Usage: bin/bench.out [vertices] [average degree] [repetitions] [SIMD min degree]
+int main(int argc, char** argv) {
+    const uint32_t n = argc > 1 ? atoi(argv[1]) : 1000000;
+    const uint32_t degree = argc > 2 ? atoi(argv[2]) : 16;
+    const unsigned reps = argc > 3 ? atoi(argv[3]) : 3;
+    const size_t simdMinDegree = argc > 4 ? atoi(argv[4]) : SIMD_RELAX_MIN_DEGREE;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> vertex(0, n - 1);
+    std::uniform_int_distribution<uint32_t> weight(1, 100);
+
+    graph_t<uint32_t, uint32_t> graph(n);
+
+    for (uint32_t v = 0; v < n; ++v) {
+        const uint32_t deg = v % 1000 == 0 ? degree * 64 : degree;
+
+        for (uint32_t j = 0; j < deg; ++j) {
+            graph[v].push_back({ vertex(rng), weight(rng) });
+        }
+    }
+
+    std::unordered_set<uint32_t> bannedVertices;
+    std::vector<uint32_t> banned = bannedSet(n);
+
+    for (uint32_t i = 0; i < n / 100; ++i) {
+        uint32_t v = vertex(rng);
+
+        if (v != 0) {
+            bannedVertices.insert(v);
+            ban(banned, v);
+        }
+    }
+
+    std::function<bool(const edgeKey<uint32_t>&)> filter = [&](const edgeKey<uint32_t>& e) {
+        return !bannedVertices.count(e.first) && !bannedVertices.count(e.second);
+    };
+
+    const csrGraph<uint32_t, uint32_t> csr(graph);
+    std::vector<uint32_t> expected, prev;
+
+    auto run = [&](const char* name, auto search) {
+        double best = -1;
+
+        for (unsigned r = 0; r < reps; ++r) {
+            const auto startTime = std::chrono::high_resolution_clock::now();
+            std::vector<uint32_t> dist = search();
+            const std::chrono::duration<double, std::milli> ms = std::chrono::high_resolution_clock::now() - startTime;
+
+            if (expected.empty()) {
+                expected = dist;
+            } else if (dist != expected) {
+                std::cout << name << " returned different distances!\n";
+            }
+
+            best = best < 0 ? ms.count() : std::min(best, ms.count());
+        }
+
+        std::cout << name << ": " << best << "ms\n";
+    };
+
+    run("adjacency list with filter", [&] {
+        return dijkstra<uint32_t, uint32_t, uint32_t>(graph, 0, &prev, filter);
+    });
+
+    run("CSR scalar", [&] {
+        return csrDijkstra<uint32_t, uint32_t, uint32_t>(csr, 0, banned, {}, prev, SIZE_MAX);
+    });
+
+    if (simdRelaxSupported()) {
+        run("CSR AVX2", [&] {
+            return csrDijkstra<uint32_t, uint32_t, uint32_t>(csr, 0, banned, {}, prev, 0);
+        });
+
+        const std::string dispatched = "CSR AVX2 from degree " + std::to_string(simdMinDegree);
+
+        run(dispatched.c_str(), [&] {
+            return csrDijkstra<uint32_t, uint32_t, uint32_t>(csr, 0, banned, {}, prev, simdMinDegree);
+        });
+    } else {
+        std::cout << "AVX2 is not supported on this CPU.\n";
+    }
+
+    return 0;
+}
@@ -2,12 +2,15 @@
 #include <climits>
 #include <csignal>
 #include <cstdlib>
+#include <fcntl.h>
 #include <iostream>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <utility>
 #include "io.hpp"
+#include "parser.hpp"
 
 std::ostream cnull(nullptr);
 std::ostream& prompt = isatty(STDIN_FILENO) ? std::cout : cnull;
@@ -34,17 +37,17 @@ int getIntInput(const int min = INT_MIN, const int max = INT_MAX) {
     return result;
 }
 
-std::vector<std::vector<std::pair<unsigned, unsigned>>> getGraphInput() {
+GraphBuffer getGraphInput() {
     prompt << "How many vertices does the graph have? ";
     unsigned n = static_cast<unsigned>(getIntInput(1));
 
-    std::vector<std::vector<std::pair<unsigned, unsigned>>> graph(n);
+    GraphBuffer graph(n);
 
     for (size_t i = 0; i < n; ++i) {
         prompt << "Enter number of edges from vertex " << i << ": ";
         unsigned deg = getIntInput(0);
 
-        graph[i] = std::vector<std::pair<unsigned, unsigned>>(deg);
+        graph.addVertex(deg);
 
         for (size_t j = 0; j < deg; ++j) {
             prompt << j + 1 << ") vertex: ";
@@ -53,7 +56,7 @@ std::vector<std::vector<std::pair<unsigned, unsigned>>> getGraphInput() {
             prompt << j + 1 << ") weight: ";
             unsigned w = getIntInput(0);
 
-            graph[i][j] = { u, w };
+            graph.addEdge(u, w);
         }
     }
 
@@ -70,25 +73,84 @@ void sendUint(const int fd, const unsigned n) {
     }
 }
 
-void sendGraph(const int fd, const std::vector<std::vector<std::pair<unsigned, unsigned>>>& graph) {
-    sendUint(fd, graph.size());
+void sendGraph(const int fd, const GraphBuffer& graph) {
+    if (!sendAll(fd, graph.data.data(), graph.data.size() * sizeof(uint32_t))) {
+        //the server may have rejected the graph part way through, print why if the reason arrived
+        uint32_t target;
+        readTarget(fd, target);
+        close(fd);
+        exit(-1);
+    }
+}
+
+void printPaths(const GraphBuffer& graph, const std::vector<std::vector<unsigned>>& paths, const unsigned k) {
+    if (paths.size() == 0) {
+        std::cout << "No path found!\n";
+        return;
+    }
+
+    if (paths.size() < k) {
+        std::cout << "Only " << paths.size() << " path/s found.\n";
+    }
 
-    for (size_t i = 0; i < graph.size(); ++i) {
-        sendUint(fd, graph[i].size());
+    std::cout << "Top " << paths.size() << " shortest paths:\n";
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        uint64_t cost = 0;
 
-        for (size_t j = 0; j < graph[i].size(); ++j) {
-            sendUint(fd, graph[i][j].first);
-            sendUint(fd, graph[i][j].second);
+        for (size_t j = 0; j + 1 < paths[i].size(); ++j) {
+            cost += graph.weight(paths[i][j], paths[i][j + 1]);
         }
+
+        std::cout << "Path " << i + 1 << ": ";
+
+        for (unsigned node : paths[i]) {
+            std::cout << node << " ";
+        }
+        
+        std::cout << "(cost = " << cost << ")\n";
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
     if (signal(SIGPIPE, SIG_IGN) == SIG_ERR) {
         perror("signal");
         return -1;
     }
 
+    //-m: the end vertex is replaced by a count followed by that many end vertices
+    //-w: K shortest walks, which may visit a vertex more than once, instead of loopless paths
+    bool multiTarget = false;
+    searchAlgorithm algorithm = searchAlgorithm::loopless;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "mw")) != -1) {
+        if (opt == 'm') {
+            multiTarget = true;
+        } else if (opt == 'w') {
+            algorithm = searchAlgorithm::walks;
+        } else {
+            std::cout << "Usage: " << argv[0] << " [-m] [-w] [file]\n";
+            return -1;
+        }
+    }
+
+    int inputFd = STDIN_FILENO;
+
+    if (optind < argc && (inputFd = open(argv[optind], O_RDONLY)) < 0) {
+        perror("open");
+        return -1;
+    }
+
+    //files are parsed in bulk, without prompting for every value
+    struct stat inputStat;
+    bool bulk = fstat(inputFd, &inputStat) == 0 && S_ISREG(inputStat.st_mode);
+    GraphRequest request;
+
+    if (bulk && !parseRequestFile(inputFd, request, multiTarget)) {
+        return -1;
+    }
+
     int s = socket(AF_INET, SOCK_STREAM, 0);
     struct sockaddr_in server_addr = { AF_INET, htons(4095), 0 };
 
@@ -98,81 +160,103 @@ int main() {
         return -1;
     }
 
-    std::vector<std::vector<std::pair<unsigned, unsigned>>> graph = getGraphInput();
+    if (!bulk) {
+        request.graph = getGraphInput();
 
-    prompt << "Enter start vertex: ";
-    unsigned start = getIntInput(0, graph.size() - 1);
+        prompt << "Enter start vertex: ";
+        request.start = getIntInput(0, request.graph.size() - 1);
 
-    prompt << "Enter end vertex: ";
-    unsigned end = getIntInput(0, graph.size() - 1);
+        if (multiTarget) {
+            prompt << "How many end vertices? ";
+            request.ends = std::vector<unsigned>(getIntInput(1));
 
-    prompt << "Enter K: ";
-    unsigned k = getIntInput(1);
+            for (size_t i = 0; i < request.ends.size(); ++i) {
+                prompt << "Enter end vertex " << i + 1 << ": ";
+                request.ends[i] = getIntInput(0, request.graph.size() - 1);
+            }
+        } else {
+            prompt << "Enter end vertex: ";
+            request.ends = { static_cast<unsigned>(getIntInput(0, request.graph.size() - 1)) };
+        }
 
-    unsigned maxThreads;
-    read32(s, &maxThreads);
+        prompt << "Enter K: ";
+        request.k = getIntInput(1);
+    }
 
-    prompt << "Enter thread count (1-" << maxThreads << "): ";
-    unsigned threads = getIntInput(1, maxThreads);
+    //a thread limit of 0 means the server turned the connection away and tells when to retry
+    unsigned maxThreads;
+    if (!read32(s, &maxThreads)) {
+        std::cout << "Could not read the thread limit from the server!\n";
+        close(s);
+        return -1;
+    }
 
-    sendGraph(s, graph);
-    sendUint(s, start);
-    sendUint(s, end);
-    sendUint(s, k);
-    sendUint(s, threads);
+    if (maxThreads == 0) {
+        unsigned seconds;
 
-    std::vector<std::vector<unsigned>> paths;
+        if (read32(s, &seconds)) {
+            std::cout << "The server is busy, retry after " << seconds << "s.\n";
+        }
 
-    if (!readPaths(s, paths)) {
         close(s);
         return -1;
     }
 
-    float time = -1;
-    if (!read32<float>(s, &time)) {
-        std::cout << "Could not read time from the server!\n";
+    if (!bulk) {
+        prompt << "Enter thread count (1-" << maxThreads << "): ";
+        request.threads = getIntInput(1, maxThreads);
+    } else if (request.threads == 0 || request.threads > maxThreads) {
+        request.threads = maxThreads;
     }
 
-    close(s);
+    const GraphBuffer& graph = request.graph;
+    const unsigned k = request.k;
 
-    if (paths.size() == 0) {
-        std::cout << "No path found!\n";
-        return 0;
-    }
+    sendGraph(s, graph);
+    sendUint(s, request.start);
 
-    if (paths.size() < k) {
-        std::cout << "Only " << paths.size() << " path/s found.\n";
+    if (!sendPath(s, request.ends)) {
+        close(s);
+        return -1;
     }
 
-    std::cout << "Top " << paths.size() << " shortest paths:\n";
+    sendUint(s, k);
+    sendUint(s, request.threads);
+    sendUint(s, static_cast<unsigned>(algorithm));
 
-    for (size_t i = 0; i < paths.size(); ++i) {
-        unsigned cost = 0;
+    //results arrive per target, as soon as the server has them
+    for (size_t i = 0; i < request.ends.size(); ++i) {
+        uint32_t target;
+        std::vector<std::vector<unsigned>> paths;
 
-        for (size_t j = 0; j + 1 < paths[i].size(); ++j) {
-            unsigned u = paths[i][j];
-            unsigned v = paths[i][j + 1];
-            
-            for (auto& e : graph[u]) {
-                if (e.first == v) { 
-                    cost += e.second; 
-                    break; 
-                }
-            }
+        if (!readTarget(s, target) || !readPaths(s, paths)) {
+            close(s);
+            return -1;
         }
 
-        std::cout << "Path " << i + 1 << ": ";
+        if (target >= request.ends.size()) {
+            std::cout << "The server returned an invalid target!\n";
+            close(s);
+            return -1;
+        }
 
-        for (unsigned node : paths[i]) {
-            std::cout << node << " ";
+        if (multiTarget) {
+            std::cout << (i ? "\n" : "") << "End vertex " << request.ends[target] << ":\n";
         }
-        
-        std::cout << "(cost = " << cost << ")\n";
+
+        printPaths(graph, paths, k);
     }
 
+    float time = -1;
+    if (!read32<float>(s, &time)) {
+        std::cout << "Could not read time from the server!\n";
+    }
+
+    close(s);
+
     if (time >= 0) {
         std::cout << "The algorithm took " << time << "ms.\n";
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include "eppstein.hpp"
+#include "threadpool.hpp"
+
+// Node of a persistent leftist heap of sidetracks, i.e. edges outside the shortest path tree to the target.
+// key is how much longer a walk gets by taking the sidetrack instead of the tree edge. Index 0 is the empty heap.
+template <typename V>
+struct sidetrack {
+    uint64_t key;
+    V from, to;
+    unsigned left, right, rank;
+};
+
+template <typename V>
+class sidetrackHeaps {
+    std::vector<sidetrack<V>> nodes;
+
+public:
+    sidetrackHeaps() : nodes(1, { 0, 0, 0, 0, 0, 0 }) {}
+
+    const sidetrack<V>& operator[](const unsigned i) const {
+        return nodes[i];
+    }
+
+    // Builds a new heap out of a sorted list, chained through the left children.
+    unsigned fromSorted(const std::vector<sidetrack<V>>& sorted) {
+        unsigned root = 0;
+
+        for (size_t i = sorted.size(); i-- > 0;) {
+            nodes.push_back(sorted[i]);
+            nodes.back().left = root;
+            nodes.back().right = 0;
+            nodes.back().rank = 1;
+            root = nodes.size() - 1;
+        }
+
+        return root;
+    }
+
+    // Copies only the nodes on the right spine of the result, so a and b stay valid.
+    unsigned merge(unsigned a, unsigned b) {
+        if (!a || !b) {
+            return a | b;
+        }
+
+        if (nodes[a].key > nodes[b].key) {
+            std::swap(a, b);
+        }
+
+        nodes.push_back(nodes[a]);
+        const unsigned c = nodes.size() - 1;
+        const unsigned right = merge(nodes[c].right, b);
+
+        sidetrack<V>& node = nodes[c];
+        node.right = right;
+
+        if (nodes[node.left].rank < nodes[node.right].rank) {
+            std::swap(node.left, node.right);
+        }
+
+        node.rank = nodes[node.right].rank + 1;
+        return c;
+    }
+};
+
+// Keeps only the cheapest of parallel edges, since walks are reported as vertex sequences.
+template <typename V, typename W>
+graph_t<V, W> withoutParallelEdges(const graph_t<V, W>& graph) {
+    graph_t<V, W> result(graph.size());
+
+    for (size_t v = 0; v < graph.size(); ++v) {
+        result[v] = graph[v];
+        std::sort(result[v].begin(), result[v].end());
+        result[v].erase(std::unique(result[v].begin(), result[v].end(), [](const edge<V, W>& a, const edge<V, W>& b) {
+            return a.first == b.first;
+        }), result[v].end());
+    }
+
+    return result;
+}
+
+template <typename V, typename W>
+graph_t<V, W> reverseGraph(const graph_t<V, W>& graph) {
+    graph_t<V, W> result(graph.size());
+
+    for (size_t v = 0; v < graph.size(); ++v) {
+        for (const edge<V, W>& e : graph[v]) {
+            result[e.first].push_back({ static_cast<V>(v), e.second });
+        }
+    }
+
+    return result;
+}
+
+template <typename V, typename W>
+std::vector<path> eppstein(const graph_t<V, W>& graph, const graph_t<V, W>& reverse, const V start,
+    const V end, const unsigned k) {
+    const V none = std::numeric_limits<V>::max();
+    const uint64_t infinity = std::numeric_limits<uint64_t>::max();
+
+    //next[v] - the following vertex on the shortest walk from v to end
+    std::vector<V> next;
+    std::vector<uint64_t> dist = dijkstra<V, W, uint64_t>(reverse, end, &next);
+
+    if (dist[start] == infinity) {
+        return {};
+    }
+
+    //heap[v] holds the sidetracks of v and of every vertex after it on the tree, so the tree is built from end
+    std::vector<std::vector<V>> children(graph.size());
+    for (size_t v = 0; v < graph.size(); ++v) {
+        if (next[v] != none) {
+            children[next[v]].push_back(v);
+        }
+    }
+
+    sidetrackHeaps<V> heaps;
+    std::vector<unsigned> heap(graph.size(), 0);
+    std::vector<V> order = { end };
+    std::vector<sidetrack<V>> own;
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        const V v = order[i];
+        own.clear();
+
+        for (const edge<V, W>& e : graph[v]) {
+            if (dist[e.first] != infinity && e.first != next[v]) {
+                own.push_back({ e.second + dist[e.first] - dist[v], v, e.first, 0, 0, 0 });
+            }
+        }
+
+        std::sort(own.begin(), own.end(), [](const sidetrack<V>& a, const sidetrack<V>& b) {
+            return a.key < b.key;
+        });
+
+        heap[v] = heaps.merge(heaps.fromSorted(own), next[v] == none ? 0 : heap[next[v]]);
+        order.insert(order.end(), children[v].begin(), children[v].end());
+    }
+
+    //every walk is the tree walk with a sequence of sidetracks taken; a walk remembers its last sidetrack
+    //and the walk it extends, and its successors swap that sidetrack for a child in the heap or add another
+    struct walk {
+        unsigned node;
+        size_t parent;
+    };
+
+    const size_t treeWalk = std::numeric_limits<size_t>::max();
+    std::vector<walk> walks;
+
+    auto buildWalk = [&](size_t w) {
+        std::vector<size_t> taken;
+
+        for (; w != treeWalk; w = walks[w].parent) {
+            taken.push_back(w);
+        }
+
+        path p;
+        V v = start;
+
+        for (auto it = taken.rbegin(); it != taken.rend(); ++it) {
+            const sidetrack<V>& s = heaps[walks[*it].node];
+
+            for (; v != s.from; v = next[v]) {
+                p.push_back(v);
+            }
+
+            p.push_back(s.from);
+            v = s.to;
+        }
+
+        for (; v != end; v = next[v]) {
+            p.push_back(v);
+        }
+
+        p.push_back(end);
+        return p;
+    };
+
+    std::vector<path> result = { buildWalk(treeWalk) };
+
+    typedef std::tuple<uint64_t, unsigned, size_t> candidate;
+    std::priority_queue<candidate, std::vector<candidate>, std::greater<candidate>> pq;
+
+    if (heap[start]) {
+        pq.push({ dist[start] + heaps[heap[start]].key, heap[start], treeWalk });
+    }
+
+    while (result.size() < k && !pq.empty()) {
+        const auto [cost, node, parent] = pq.top();
+        pq.pop();
+
+        walks.push_back({ node, parent });
+        result.push_back(buildWalk(walks.size() - 1));
+
+        const sidetrack<V>& s = heaps[node];
+
+        for (unsigned child : { s.left, s.right }) {
+            if (child) {
+                pq.push({ cost - s.key + heaps[child].key, child, parent });
+            }
+        }
+
+        if (heap[s.to]) {
+            pq.push({ cost + heaps[heap[s.to]].key, heap[s.to], walks.size() - 1 });
+        }
+    }
+
+    return result;
+}
+
+template <typename V, typename W>
+void eppsteinToMany(const graph_t<V, W>& graph, const V start, const std::vector<V>& ends, const unsigned k,
+    const unsigned threads, std::function<void(const size_t, std::vector<path>&)> onResult) {
+    if (start > graph.size() - 1) {
+        throw std::invalid_argument("Provided start is not a vertex in the graph.");
+    }
+
+    for (V end : ends) {
+        if (end > graph.size() - 1) {
+            throw std::invalid_argument("Provided end is not a vertex in the graph.");
+        }
+    }
+
+    if (k == 0) {
+        throw std::invalid_argument("Invalid K! Must be at least 1.");
+    }
+
+    if (ends.empty()) {
+        return;
+    }
+
+    const graph_t<V, W> simple = withoutParallelEdges(graph);
+    const graph_t<V, W> reverse = reverseGraph(simple);
+
+    //every target needs its own tree, so targets run side by side
+    Threadpool targetPool(std::min<size_t>(threads, ends.size()));
+
+    for (size_t t = 0; t < ends.size(); ++t) {
+        targetPool.enqueue([&, t]() {
+            std::vector<path> paths = eppstein(simple, reverse, start, ends[t], k);
+            onResult(t, paths);
+        });
+    }
+
+    targetPool.wait_finished();
+}
+
+#define INSTANTIATE_EPPSTEIN(V, W) \
+    template void eppsteinToMany<V, W>(const graph_t<V, W>&, const V, const std::vector<V>&, const unsigned, \
+        const unsigned, std::function<void(const size_t, std::vector<path>&)>);
+
+INSTANTIATE_EPPSTEIN(uint16_t, uint16_t)
+INSTANTIATE_EPPSTEIN(uint16_t, uint32_t)
+INSTANTIATE_EPPSTEIN(uint32_t, uint16_t)
+INSTANTIATE_EPPSTEIN(uint32_t, uint32_t)
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "yen.hpp"
+
+// K shortest walks from start to each of ends (Eppstein's algorithm). Unlike yen(), walks may repeat vertices,
+// so a walk around a cycle counts as a new one. Walk costs are kept in 64 bits, since they grow with K.
+// onResult is called with the index of each target as soon as its walks are ready, possibly from several threads.
+template <typename V, typename W>
+void eppsteinToMany(const graph_t<V, W>& graph, const V start, const std::vector<V>& ends, const unsigned k,
+    const unsigned threads, std::function<void(const size_t, std::vector<path>&)> onResult);
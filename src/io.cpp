@@ -2,13 +2,39 @@
 #include <unistd.h>
 #include "io.hpp"
 
-bool readPath(const int fd, std::vector<unsigned>& p) {
+bool sendAll(const int fd, const void* data, size_t size) {
+    const char* buf = static_cast<const char*>(data);
+
+    while (size > 0) {
+        ssize_t count = write(fd, buf, size);
+
+        if (count < 0) {
+            perror("write");
+            return false;
+        }
+
+        buf += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+bool readPath(const int fd, std::vector<unsigned>& p, const uint32_t maxLength, bool* tooLong) {
     uint32_t n;
     if (!read32<uint32_t>(fd, &n)) {
         std::cout << "There was an error when reading the result.\n";
         return false;
     }
 
+    if (n > maxLength) {
+        if (tooLong) {
+            *tooLong = true;
+        }
+
+        return false;
+    }
+
     p = std::vector<unsigned>(n);
 
     for (size_t i = 0; i < n; ++i) {
@@ -36,29 +62,58 @@ bool sendPath(const int fd, const std::vector<unsigned>& p) {
     return true;
 }
 
-bool readPaths(const int fd, std::vector<std::vector<unsigned>>& paths) {
+void printServerError(const int fd) {
+    std::cout << "The server returned with an error:\n";
+    char buffer[1024];
+    ssize_t count;
+
+    while ((count = read(fd, buffer, sizeof(buffer)))) {
+        if (write(1, buffer, count) < 0) {
+            perror("write");
+            return;
+        }
+    }
+
+    if (count < 0) {
+        perror("read");
+    }
+}
+
+bool readTarget(const int fd, uint32_t& target) {
     int32_t n;
     if (!read32<int32_t>(fd, &n)) {
         std::cout << "There was an error when reading the result.\n";
         return false;
     }
 
-    if (n < 0) {
-        std::cout << "The server returned with an error:\n";
-        char buffer[1024];
-        ssize_t count;
+    if (n == -2) {
+        uint32_t seconds;
 
-        while ((count = read(fd, buffer, sizeof(buffer)))) {
-            if (write(1, buffer, count) < 0) {
-                perror("write");
-                return false;
-            }
+        if (read32<uint32_t>(fd, &seconds)) {
+            std::cout << "The server is overloaded, retry after " << seconds << "s.\n";
         }
 
-        if (count < 0) {
-            perror("read");
-        }
+        return false;
+    }
 
+    if (n < 0) {
+        printServerError(fd);
+        return false;
+    }
+
+    target = n;
+    return true;
+}
+
+bool readPaths(const int fd, std::vector<std::vector<unsigned>>& paths) {
+    int32_t n;
+    if (!read32<int32_t>(fd, &n)) {
+        std::cout << "There was an error when reading the result.\n";
+        return false;
+    }
+
+    if (n < 0) {
+        printServerError(fd);
         return false;
     }
 
@@ -87,13 +142,24 @@ bool sendPaths(const int fd, const std::vector<std::vector<unsigned>>& paths) {
     return true;
 }
 
-bool readGraph(const int fd, std::vector<std::vector<std::pair<uint32_t, uint32_t>>>& graph) {
+bool readGraph(const int fd, std::vector<std::vector<std::pair<uint32_t, uint32_t>>>& graph,
+    const uint64_t maxBytes, bool* tooLarge) {
     uint32_t n;
 
     if (!read32<uint32_t>(fd, &n)) {
         return false;
     }
 
+    uint64_t bytes = static_cast<uint64_t>(n) * sizeof(std::vector<std::pair<uint32_t, uint32_t>>);
+
+    if (bytes > maxBytes) {
+        if (tooLarge) {
+            *tooLarge = true;
+        }
+
+        return false;
+    }
+
     graph = std::vector<std::vector<std::pair<uint32_t, uint32_t>>>(n);
 
     for (size_t i = 0; i < n; ++i) {
@@ -103,6 +169,18 @@ bool readGraph(const int fd, std::vector<std::vector<std::pair<uint32_t, uint32_
             return false;
         }
 
+        bytes += static_cast<uint64_t>(deg) * sizeof(std::pair<uint32_t, uint32_t>);
+
+        if (bytes > maxBytes) {
+            graph = {};
+
+            if (tooLarge) {
+                *tooLarge = true;
+            }
+
+            return false;
+        }
+
         graph[i] = std::vector<std::pair<uint32_t, uint32_t>>(deg);
 
         for (size_t j = 0; j < deg; ++j) {
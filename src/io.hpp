@@ -1,8 +1,15 @@
+#include <bit>
 #include <cstdint>
 #include <cstdio>
 #include <netinet/in.h>
 #include <vector>
 
+// Sent after the thread count: loopless paths (Yen) or walks that may repeat vertices (Eppstein).
+enum class searchAlgorithm : uint32_t {
+    loopless = 0,
+    walks = 1
+};
+
 template <typename T>
 bool read32(int fd, T* value) {
     static_assert(sizeof(T) == 4, "Value must be 32-bit.");
@@ -30,10 +37,23 @@ ssize_t send32(const int fd, const T value) {
     return write(fd, &nToSend, sizeof(uint32_t));
 }
 
-bool readPath(const int fd, std::vector<unsigned>& p);
+bool sendAll(const int fd, const void* data, size_t size);
+
+// Fails before allocating if the announced length is above maxLength, and sets tooLong if given.
+bool readPath(const int fd, std::vector<unsigned>& p, const uint32_t maxLength = UINT32_MAX, bool* tooLong = nullptr);
 bool sendPath(const int fd, const std::vector<unsigned>& p);
 
+// Prints the error message the server sent instead of a result.
+void printServerError(const int fd);
+
+// Reads the index of the target the following paths lead to. Fails with a printed message if the server
+// sent an error (-1 followed by text) or rejected the request as overloaded (-2 followed by seconds to wait).
+bool readTarget(const int fd, uint32_t& target);
+
 bool readPaths(const int fd, std::vector<std::vector<unsigned>>& paths);
 bool sendPaths(const int fd, const std::vector<std::vector<unsigned>>& paths);
 
-bool readGraph(const int fd, std::vector<std::vector<std::pair<uint32_t, uint32_t>>>& graph);
\ No newline at end of file
+// Fails as soon as the announced vertex count or degrees would make the graph take more than maxBytes,
+// before allocating it, and sets tooLarge if given.
+bool readGraph(const int fd, std::vector<std::vector<std::pair<uint32_t, uint32_t>>>& graph,
+    const uint64_t maxBytes = UINT64_MAX, bool* tooLarge = nullptr);
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include <bit>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "parser.hpp"
+
+GraphBuffer::GraphBuffer(const unsigned n) : data{ htonl(n) } {
+    offsets.reserve(n);
+}
+
+unsigned GraphBuffer::size() const {
+    return ntohl(data[0]);
+}
+
+void GraphBuffer::addVertex(const unsigned deg) {
+    offsets.push_back(data.size());
+    data.push_back(htonl(deg));
+}
+
+void GraphBuffer::addEdge(const unsigned u, const unsigned w) {
+    data.push_back(htonl(u));
+    data.push_back(htonl(w));
+}
+
+unsigned GraphBuffer::weight(const unsigned u, const unsigned v) const {
+    size_t begin = offsets[u] + 1;
+    size_t end = begin + 2 * ntohl(data[offsets[u]]);
+    unsigned cheapest = 0;
+    bool found = false;
+
+    //the server follows the cheapest of parallel edges, so that is the one a path's cost includes
+    for (size_t i = begin; i < end; i += 2) {
+        if (ntohl(data[i]) == v && (!found || ntohl(data[i + 1]) < cheapest)) {
+            cheapest = ntohl(data[i + 1]);
+            found = true;
+        }
+    }
+
+    return cheapest;
+}
+
+class Scanner {
+    const char* cur;
+    const char* end;
+
+    static bool isDigit(const char c) {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    //SWAR: true if all 8 bytes of the chunk are ASCII digits
+    static bool allDigits(const uint64_t chunk) {
+        return ((chunk & 0xF0F0F0F0F0F0F0F0) == 0x3030303030303030)
+            && (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) == 0x3030303030303030);
+    }
+
+    //SWAR: converts 8 ASCII digits (first digit in the lowest byte) to their value
+    static uint64_t parse8(uint64_t chunk) {
+        chunk -= 0x3030303030303030;
+        chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FF;
+        chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFF;
+        return (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFF;
+    }
+
+public:
+    Scanner(const char* begin, const char* end) : cur(begin), end(end) {}
+
+    size_t remaining() const {
+        return end - cur;
+    }
+
+    bool atEnd() {
+        while (cur < end && !isDigit(*cur) && *cur != '-') {
+            ++cur;
+        }
+
+        return cur == end;
+    }
+
+    //reads the next non-negative integer up to max, false on end of input or invalid token
+    bool next(unsigned& value, const unsigned max = INT_MAX) {
+        if (atEnd() || *cur == '-') {
+            return false;
+        }
+
+        uint64_t result = 0;
+
+        if constexpr (std::endian::native == std::endian::little) {
+            uint64_t chunk;
+
+            while (end - cur >= 8 && (std::memcpy(&chunk, cur, 8), allDigits(chunk))) {
+                result = result * 100000000 + parse8(chunk);
+                cur += 8;
+
+                if (result > max) {
+                    return false;
+                }
+            }
+        }
+
+        while (cur < end && isDigit(*cur)) {
+            result = result * 10 + (*cur++ - '0');
+
+            if (result > max) {
+                return false;
+            }
+        }
+
+        value = static_cast<unsigned>(result);
+        return true;
+    }
+};
+
+bool parseRequest(Scanner& scanner, GraphRequest& request, const bool multiTarget) {
+    unsigned n;
+
+    if (!scanner.next(n) || n == 0) {
+        std::cout << "Invalid vertex count!\n";
+        return false;
+    }
+
+    request.graph = GraphBuffer(n);
+    request.graph.data.reserve(scanner.remaining() / 4);
+
+    for (unsigned i = 0; i < n; ++i) {
+        unsigned deg;
+
+        if (!scanner.next(deg)) {
+            std::cout << "Invalid number of edges from vertex " << i << "!\n";
+            return false;
+        }
+
+        request.graph.addVertex(deg);
+
+        for (unsigned j = 0; j < deg; ++j) {
+            unsigned u, w;
+
+            if (!scanner.next(u, n - 1) || !scanner.next(w)) {
+                std::cout << "Invalid edge " << j + 1 << " from vertex " << i << "!\n";
+                return false;
+            }
+
+            request.graph.addEdge(u, w);
+        }
+    }
+
+    if (!scanner.next(request.start, n - 1)) {
+        std::cout << "Invalid start vertex!\n";
+        return false;
+    }
+
+    unsigned targets = 1;
+
+    if (multiTarget && (!scanner.next(targets) || targets == 0)) {
+        std::cout << "Invalid number of end vertices!\n";
+        return false;
+    }
+
+    request.ends = std::vector<unsigned>(targets);
+
+    for (unsigned& end : request.ends) {
+        if (!scanner.next(end, n - 1)) {
+            std::cout << "Invalid end vertex!\n";
+            return false;
+        }
+    }
+
+    if (!scanner.next(request.k) || request.k == 0) {
+        std::cout << "Invalid K! Must be at least 1.\n";
+        return false;
+    }
+
+    if (!scanner.atEnd() && (!scanner.next(request.threads) || request.threads == 0)) {
+        std::cout << "Invalid thread count!\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool parseRequestFile(const int fd, GraphRequest& request, const bool multiTarget) {
+    struct stat st;
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        return false;
+    }
+
+    if (st.st_size == 0) {
+        std::cout << "The input file is empty!\n";
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+
+    const char* begin = static_cast<const char*>(mapped);
+    Scanner scanner(begin, begin + st.st_size);
+    bool result = parseRequest(scanner, request, multiTarget);
+
+    munmap(mapped, st.st_size);
+    return result;
+}
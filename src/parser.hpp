@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Graph serialized exactly as it is sent to the server: [n] then for every vertex [deg][u w]...,
+// all values already in network byte order.
+struct GraphBuffer {
+    std::vector<uint32_t> data;
+    std::vector<size_t> offsets; // index of each vertex's degree in data
+
+    GraphBuffer(const unsigned n = 0);
+
+    unsigned size() const;
+    void addVertex(const unsigned deg);
+    void addEdge(const unsigned u, const unsigned w);
+
+    // Weight of the cheapest edge u -> v, or 0 if there is none.
+    unsigned weight(const unsigned u, const unsigned v) const;
+};
+
+struct GraphRequest {
+    GraphBuffer graph;
+    unsigned start, k;
+    std::vector<unsigned> ends;
+    unsigned threads = 0; // 0 if the input did not specify a thread count
+};
+
+// Parses a whole request (graph, start, end, K and optionally thread count) from a regular file
+// by memory-mapping it. With multiTarget, end is a count followed by that many end vertices.
+// Prints the reason and returns false on malformed input.
+bool parseRequestFile(const int fd, GraphRequest& request, const bool multiTarget = false);
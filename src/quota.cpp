@@ -0,0 +1,163 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/mman.h>
+#include "quota.hpp"
+
+ClientQuota::tableLock::tableLock(table* shared) : shared(shared) {
+    if (pthread_mutex_lock(&shared->mut) == EOWNERDEAD) {
+        //the dead worker's entries are released by the supervisor
+        pthread_mutex_consistent(&shared->mut);
+    }
+}
+
+ClientQuota::tableLock::~tableLock() {
+    pthread_mutex_unlock(&shared->mut);
+}
+
+ClientQuota::ClientQuota() {
+    void* mapped = mmap(nullptr, sizeof(table), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        exit(-1);
+    }
+
+    //anonymous mappings are zeroed, so every slot starts free
+    shared = static_cast<table*>(mapped);
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&shared->mut, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+ClientQuota::~ClientQuota() {
+    munmap(shared, sizeof(table));
+}
+
+void ClientQuota::setOwner(const uint16_t owner) {
+    this->owner = owner;
+}
+
+size_t ClientQuota::slot(const uint32_t client) {
+    return (client * 2654435761u) % CLIENT_TABLE_SIZE;
+}
+
+// All owners' entries for a client share its home slot, so they lie in one run of occupied slots.
+ClientQuota::entry* ClientQuota::find(const uint32_t client) {
+    for (size_t i = slot(client), probes = 0; probes < CLIENT_TABLE_SIZE; i = (i + 1) % CLIENT_TABLE_SIZE, ++probes) {
+        entry& e = shared->entries[i];
+
+        if (e.requests == 0) {
+            e.client = client;
+            e.owner = owner;
+            e.memory = 0;
+            return &e;
+        }
+
+        if (e.client == client && e.owner == owner) {
+            return &e;
+        }
+    }
+
+    return nullptr;
+}
+
+void ClientQuota::total(const uint32_t client, unsigned& requests, uint64_t& memory) const {
+    requests = 0;
+    memory = 0;
+
+    for (size_t i = slot(client), probes = 0; probes < CLIENT_TABLE_SIZE; i = (i + 1) % CLIENT_TABLE_SIZE, ++probes) {
+        const entry& e = shared->entries[i];
+
+        if (e.requests == 0) {
+            return;
+        }
+
+        if (e.client == client) {
+            requests += e.requests;
+            memory += e.memory;
+        }
+    }
+}
+
+// Backward shift deletion: entries after the freed slot move into it unless that would put them before their home slot.
+void ClientQuota::erase(size_t i) {
+    for (size_t j = (i + 1) % CLIENT_TABLE_SIZE; shared->entries[j].requests != 0; j = (j + 1) % CLIENT_TABLE_SIZE) {
+        const size_t home = slot(shared->entries[j].client);
+        const bool reachable = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+
+        if (!reachable) {
+            shared->entries[i] = shared->entries[j];
+            i = j;
+        }
+    }
+
+    shared->entries[i].requests = 0;
+}
+
+bool ClientQuota::admit(const uint32_t client) {
+    tableLock lock(shared);
+    unsigned requests;
+    uint64_t memory;
+
+    total(client, requests, memory);
+
+    if (requests >= MAX_REQUESTS_PER_CLIENT) {
+        return false;
+    }
+
+    entry* e = find(client);
+
+    if (!e) {
+        return false;
+    }
+
+    ++e->requests;
+    return true;
+}
+
+bool ClientQuota::reserve(const uint32_t client, const uint64_t memory) {
+    tableLock lock(shared);
+    unsigned requests;
+    uint64_t used;
+
+    total(client, requests, used);
+    entry* e = find(client);
+
+    if (used + memory > MAX_CLIENT_MEMORY) {
+        if (--e->requests == 0) {
+            erase(e - shared->entries);
+        }
+
+        return false;
+    }
+
+    e->memory += memory;
+    return true;
+}
+
+void ClientQuota::release(const uint32_t client, const uint64_t memory) {
+    tableLock lock(shared);
+    entry* e = find(client);
+
+    e->memory -= memory;
+
+    if (--e->requests == 0) {
+        erase(e - shared->entries);
+    }
+}
+
+void ClientQuota::releaseOwner(const uint16_t owner) {
+    tableLock lock(shared);
+
+    for (size_t i = 0; i < CLIENT_TABLE_SIZE; ++i) {
+        //erasing may shift another of the owner's entries into slot i
+        while (shared->entries[i].requests != 0 && shared->entries[i].owner == owner) {
+            erase(i);
+        }
+    }
+}
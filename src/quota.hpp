@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef QUOTA_H
+#define QUOTA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+
+#define MAX_REQUESTS_PER_CLIENT 4
+#define MAX_CLIENT_MEMORY (4ull << 30)
+#define CLIENT_TABLE_SIZE 4096
+
+// Requests in flight and estimated memory per client address. The table lives in an anonymous shared mapping,
+// so server processes forked after it is created enforce the per-client limits together rather than each on its own.
+// Usage is recorded per owner (the worker process index), so the share of a crashed worker can be released.
+class ClientQuota {
+    struct entry {
+        uint32_t client;
+        uint16_t owner;
+        uint16_t requests; // 0 marks a free slot
+        uint64_t memory;
+    };
+
+    struct table {
+        pthread_mutex_t mut; // process-shared and robust
+        entry entries[CLIENT_TABLE_SIZE];
+    };
+
+    // Locks the table; a worker that died holding the lock leaves it consistent enough to go on.
+    class tableLock {
+        table* shared;
+
+    public:
+        tableLock(table* shared);
+        ~tableLock();
+    };
+
+    table* shared;
+    uint16_t owner = 0;
+
+    static size_t slot(const uint32_t client);
+    entry* find(const uint32_t client);
+    void total(const uint32_t client, unsigned& requests, uint64_t& memory) const;
+    void erase(size_t i);
+
+public:
+
+    ClientQuota();
+    ~ClientQuota();
+
+    ClientQuota(const ClientQuota&) = delete;
+    ClientQuota& operator=(const ClientQuota&) = delete;
+
+    // Sets the owner recorded by this process, called in each worker process after it is forked.
+    void setOwner(const uint16_t owner);
+
+    // Counts a new request for the client, unless it already has MAX_REQUESTS_PER_CLIENT in flight
+    // in any process or the table is full.
+    bool admit(const uint32_t client);
+
+    // Adds an admitted request's memory, unless the client would exceed MAX_CLIENT_MEMORY,
+    // in which case the request is released.
+    bool reserve(const uint32_t client, const uint64_t memory);
+
+    // Releases an admitted request and the memory reserved for it.
+    void release(const uint32_t client, const uint64_t memory);
+
+    // Releases everything recorded by an owner, for a worker process that stopped.
+    void releaseOwner(const uint16_t owner);
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <climits>
+#include <immintrin.h>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include "relax.hpp"
+
+template <typename V, typename W>
+csrGraph<V, W>::csrGraph(const graph_t<V, W>& graph) : offsets(graph.size() + 1, 0) {
+    for (size_t v = 0; v < graph.size(); ++v) {
+        offsets[v + 1] = offsets[v] + graph[v].size();
+    }
+
+    targets.reserve(offsets.back());
+    weights.reserve(offsets.back());
+
+    for (const std::vector<edge<V, W>>& neighbours : graph) {
+        for (const edge<V, W>& e : neighbours) {
+            targets.push_back(e.first);
+            weights.push_back(e.second);
+        }
+    }
+}
+
+std::vector<uint32_t> bannedSet(const size_t n) {
+    return std::vector<uint32_t>((n + 31) / 32, 0);
+}
+
+bool simdRelaxSupported() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+template <typename V, typename W, typename D>
+void relaxScalar(const V* targets, const W* weights, const size_t count, const V from, const D d,
+    const uint32_t* banned, D* dist, V* prev, std::vector<V>& improved) {
+    for (size_t j = 0; j < count; ++j) {
+        const V to = targets[j];
+
+        if ((banned[to >> 5] >> (to & 31)) & 1) {
+            continue;
+        }
+
+        const D candidate = d + weights[j];
+
+        if (candidate < dist[to]) {
+            dist[to] = candidate;
+            prev[to] = from;
+            improved.push_back(to);
+        }
+    }
+}
+
+//loads 8 IDs or weights as 32-bit lanes
+template <typename T>
+__attribute__((target("avx2"))) inline __m256i load8(const T* p) {
+    if constexpr (sizeof(T) == 4) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    } else {
+        return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+}
+
+//8 edges at a time: gather the targets' distances and banned bits, keep the lanes that improve
+//and update those one by one, since a block may contain the same target twice
+template <typename V, typename W>
+__attribute__((target("avx2"))) void relaxAvx2(const V* targets, const W* weights, const size_t count, const V from,
+    const uint32_t d, const uint32_t* banned, uint32_t* dist, V* prev, std::vector<V>& improved) {
+    const __m256i bias = _mm256_set1_epi32(INT_MIN);
+    const __m256i base = _mm256_set1_epi32(d);
+    const __m256i bitMask = _mm256_set1_epi32(31);
+    const __m256i one = _mm256_set1_epi32(1);
+    size_t j = 0;
+
+    for (; j + 8 <= count; j += 8) {
+        const __m256i to = load8(targets + j);
+        const __m256i candidate = _mm256_add_epi32(base, load8(weights + j));
+        const __m256i old = _mm256_i32gather_epi32(reinterpret_cast<const int*>(dist), to, 4);
+        const __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(banned), _mm256_srli_epi32(to, 5), 4);
+        const __m256i bits = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(to, bitMask)), one);
+
+        //unsigned old > candidate, as a signed comparison of biased values
+        const __m256i better = _mm256_cmpgt_epi32(_mm256_xor_si256(old, bias), _mm256_xor_si256(candidate, bias));
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(_mm256_cmpeq_epi32(bits, one), better)));
+
+        while (mask) {
+            const unsigned lane = __builtin_ctz(mask);
+            mask &= mask - 1;
+
+            const V v = targets[j + lane];
+            const uint32_t c = d + weights[j + lane];
+
+            if (c < dist[v]) {
+                dist[v] = c;
+                prev[v] = from;
+                improved.push_back(v);
+            }
+        }
+    }
+
+    relaxScalar<V, W, uint32_t>(targets + j, weights + j, count - j, from, d, banned, dist, prev, improved);
+}
+
+template <typename V, typename W, typename D>
+std::vector<D> csrDijkstra(const csrGraph<V, W>& graph, const V start, const std::vector<uint32_t>& banned,
+    const std::vector<V>& bannedFromStart, std::vector<V>& prev, const size_t simdMinDegree) {
+    if (start > graph.size() - 1) {
+        throw std::invalid_argument("Provided start is not a vertex in the graph.");
+    }
+
+    //gather indices are signed 32-bit
+    const bool vectorized = std::is_same_v<D, uint32_t> && simdRelaxSupported() && graph.size() <= INT_MAX;
+
+    std::vector<D> dist(graph.size(), std::numeric_limits<D>::max());
+    prev = std::vector<V>(graph.size(), std::numeric_limits<V>::max());
+    dist[start] = 0;
+
+    typedef std::pair<D, V> entry;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> pq;
+    std::vector<V> improved;
+
+    //start is settled first and never improved, so its banned edges only need checking here
+    for (size_t j = graph.offsets[start]; j < graph.offsets[start + 1]; ++j) {
+        const V to = graph.targets[j];
+
+        if (std::find(bannedFromStart.begin(), bannedFromStart.end(), to) == bannedFromStart.end()) {
+            relaxScalar<V, W, D>(&graph.targets[j], &graph.weights[j], 1, start, 0, banned.data(), dist.data(), prev.data(), improved);
+        }
+    }
+
+    for (V v : improved) {
+        pq.push({ dist[v], v });
+    }
+
+    while (!pq.empty()) {
+        V v = pq.top().second;
+        D d = pq.top().first;
+        pq.pop();
+
+        if (d > dist[v]) {
+            continue;
+        }
+
+        const size_t begin = graph.offsets[v];
+        const size_t count = graph.offsets[v + 1] - begin;
+        improved.clear();
+
+        if constexpr (std::is_same_v<D, uint32_t>) {
+            if (vectorized && count >= simdMinDegree) {
+                relaxAvx2<V, W>(&graph.targets[begin], &graph.weights[begin], count, v, d, banned.data(), dist.data(), prev.data(), improved);
+            } else {
+                relaxScalar<V, W, D>(&graph.targets[begin], &graph.weights[begin], count, v, d, banned.data(), dist.data(), prev.data(), improved);
+            }
+        } else {
+            relaxScalar<V, W, D>(&graph.targets[begin], &graph.weights[begin], count, v, d, banned.data(), dist.data(), prev.data(), improved);
+        }
+
+        for (V u : improved) {
+            pq.push({ dist[u], u });
+        }
+    }
+
+    return dist;
+}
+
+#define INSTANTIATE_RELAX(V, W, D) \
+    template std::vector<D> csrDijkstra<V, W, D>(const csrGraph<V, W>&, const V, const std::vector<uint32_t>&, \
+        const std::vector<V>&, std::vector<V>&, const size_t);
+
+template struct csrGraph<uint16_t, uint16_t>;
+template struct csrGraph<uint16_t, uint32_t>;
+template struct csrGraph<uint32_t, uint16_t>;
+template struct csrGraph<uint32_t, uint32_t>;
+
+INSTANTIATE_RELAX(uint16_t, uint16_t, uint32_t)
+INSTANTIATE_RELAX(uint16_t, uint16_t, uint64_t)
+INSTANTIATE_RELAX(uint16_t, uint32_t, uint32_t)
+INSTANTIATE_RELAX(uint16_t, uint32_t, uint64_t)
+INSTANTIATE_RELAX(uint32_t, uint16_t, uint32_t)
+INSTANTIATE_RELAX(uint32_t, uint16_t, uint64_t)
+INSTANTIATE_RELAX(uint32_t, uint32_t, uint32_t)
+INSTANTIATE_RELAX(uint32_t, uint32_t, uint64_t)
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "yen.hpp"
+
+// Shortest edge block relaxed with AVX2. Gathers only beat the scalar loop once a block is long enough
+// to amortize them (bench.cpp on an AVX2 host: slower at average degree 16, even at 64 and 256, about 25% faster
+// at 1024 and above). Blocks between this threshold and 1024 relax at the same speed either way, so it only has
+// to keep the short blocks, where gathers lose, on the scalar loop.
+#define SIMD_RELAX_MIN_DEGREE 128
+
+// Structure-of-arrays (CSR) copy of a graph: the edges of v are targets/weights[offsets[v], offsets[v + 1]).
+// Keeping a vertex's targets and weights contiguous lets its whole edge block be relaxed with vector instructions.
+template <typename V, typename W>
+struct csrGraph {
+    std::vector<size_t> offsets;
+    std::vector<V> targets;
+    std::vector<W> weights;
+
+    csrGraph(const graph_t<V, W>& graph);
+
+    size_t size() const {
+        return offsets.size() - 1;
+    }
+};
+
+// Bitset of banned vertices, one bit per vertex.
+std::vector<uint32_t> bannedSet(const size_t n);
+
+inline void ban(std::vector<uint32_t>& banned, const uint32_t v) {
+    banned[v >> 5] |= 1u << (v & 31);
+}
+
+// True if the relaxation kernel can use AVX2 on this CPU.
+bool simdRelaxSupported();
+
+// Dijkstra over a CSR graph that never enters banned vertices and does not take the edges from start to
+// bannedFromStart. Edge blocks of at least simdMinDegree edges are relaxed with AVX2 gathers when the CPU
+// supports it and distances are 32-bit; other blocks, and the remainder of every block, one edge at a time.
+template <typename V, typename W, typename D>
+std::vector<D> csrDijkstra(const csrGraph<V, W>& graph, const V start, const std::vector<uint32_t>& banned,
+    const std::vector<V>& bannedFromStart, std::vector<V>& prev, const size_t simdMinDegree = SIMD_RELAX_MIN_DEGREE);
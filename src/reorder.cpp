@@ -0,0 +1,73 @@
+#include <algorithm>
+#include "reorder.hpp"
+
+vertexOrder reorderGraph(graph_t<uint32_t, uint32_t>& graph) {
+    const uint32_t n = graph.size();
+    auto lowerDegree = [&](const uint32_t u, const uint32_t v) {
+        return graph[u].size() < graph[v].size();
+    };
+
+    std::vector<uint32_t> byDegree(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        byDegree[v] = v;
+    }
+
+    std::stable_sort(byDegree.begin(), byDegree.end(), lowerDegree);
+
+    vertexOrder order;
+    order.toOld.reserve(n);
+    std::vector<bool> visited(n, false);
+
+    //restart the BFS from the lowest degree unvisited vertex for every component
+    for (uint32_t root : byDegree) {
+        if (visited[root]) {
+            continue;
+        }
+
+        visited[root] = true;
+        order.toOld.push_back(root);
+
+        for (size_t head = order.toOld.size() - 1; head < order.toOld.size(); ++head) {
+            const size_t levelStart = order.toOld.size();
+
+            for (const edge<uint32_t, uint32_t>& e : graph[order.toOld[head]]) {
+                if (!visited[e.first]) {
+                    visited[e.first] = true;
+                    order.toOld.push_back(e.first);
+                }
+            }
+
+            std::stable_sort(order.toOld.begin() + levelStart, order.toOld.end(), lowerDegree);
+        }
+    }
+
+    std::reverse(order.toOld.begin(), order.toOld.end());
+
+    order.toNew = std::vector<uint32_t>(n);
+    for (uint32_t v = 0; v < n; ++v) {
+        order.toNew[order.toOld[v]] = v;
+    }
+
+    graph_t<uint32_t, uint32_t> reordered(n);
+
+    for (uint32_t v = 0; v < n; ++v) {
+        reordered[v] = std::move(graph[order.toOld[v]]);
+
+        for (edge<uint32_t, uint32_t>& e : reordered[v]) {
+            e.first = order.toNew[e.first];
+        }
+
+        std::sort(reordered[v].begin(), reordered[v].end());
+    }
+
+    graph = std::move(reordered);
+    return order;
+}
+
+void restorePaths(std::vector<path>& paths, const vertexOrder& order) {
+    for (path& p : paths) {
+        for (unsigned& v : p) {
+            v = order.toOld[v];
+        }
+    }
+}
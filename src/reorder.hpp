@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "yen.hpp"
+
+struct vertexOrder {
+    std::vector<uint32_t> toOld; // new ID -> original ID
+    std::vector<uint32_t> toNew; // original ID -> new ID
+};
+
+// Renumbers the vertices in reverse Cuthill-McKee order (BFS over outgoing edges, lower degree first)
+// so that neighbours get nearby IDs, and sorts every adjacency list by target.
+vertexOrder reorderGraph(graph_t<uint32_t, uint32_t>& graph);
+
+// Translates paths over the reordered graph back to the original IDs.
+void restorePaths(std::vector<path>& paths, const vertexOrder& order);
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+#include "affinity.hpp"
+#include "scheduler.hpp"
+
+Scheduler::Scheduler(size_t n, ClientQuota& quota, const bool pin) : stats(n), quota(quota) {
+    //a process already pinned (server -n) spreads its workers over its own nodes only
+    const std::vector<unsigned> nodes = allowedNumaNodes();
+
+    for (size_t i = 0; i < n; ++i) {
+        if (pin) {
+            stats[i].node = nodes[i % nodes.size()];
+        }
+
+        threads.emplace_back([this, i] {
+            //search workspaces are allocated by the worker's threads, so pinning also keeps them node-local
+            if (stats[i].node >= 0 && !pinToNumaNode(stats[i].node)) {
+                std::cout << "Could not pin worker " << i << " to NUMA node " << stats[i].node << ".\n";
+            }
+
+            while (true) {
+                job next;
+
+                {
+                    std::unique_lock<std::mutex> lock(mut);
+
+                    cv.wait(lock, [this] {
+                        return !running || !jobs.empty();
+                    });
+
+                    if (!running && jobs.empty()) {
+                        return;
+                    }
+
+                    next = jobs.top();
+                    jobs.pop();
+                }
+
+                const auto startTime = std::chrono::steady_clock::now();
+                next.task();
+                const std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - startTime;
+
+                finish(next.client, next.cost, next.memory);
+
+                {
+                    std::unique_lock<std::mutex> lock(mut);
+                    ++stats[i].jobs;
+                    stats[i].busyMs += ms.count();
+
+                    if (std::chrono::steady_clock::now() - lastReport >= std::chrono::milliseconds(STATS_INTERVAL_MS)) {
+                        lastReport = std::chrono::steady_clock::now();
+                        printNodeStats();
+                    }
+                }
+            }
+        });
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::unique_lock<std::mutex> lock(mut);
+        running = false;
+    }
+
+    cv.notify_all();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+unsigned Scheduler::retryAfter() const {
+    //time for the workers to get through the pending work, in whole seconds
+    return std::max<uint64_t>(1, pendingCost / COST_UNITS_PER_MS / std::max<size_t>(1, threads.size()) / 1000 + 1);
+}
+
+void Scheduler::finish(const uint32_t client, const uint64_t cost, const uint64_t memory) {
+    {
+        std::unique_lock<std::mutex> lock(mut);
+        pendingCost -= cost;
+    }
+
+    quota.release(client, memory);
+}
+
+unsigned Scheduler::admit(const uint32_t client) {
+    std::unique_lock<std::mutex> lock(mut);
+
+    if (pendingCost / COST_UNITS_PER_MS / std::max<size_t>(1, threads.size()) > MAX_QUEUED_MS || !quota.admit(client)) {
+        return retryAfter();
+    }
+
+    return 0;
+}
+
+unsigned Scheduler::submit(const uint32_t client, const uint64_t cost, const uint64_t memory, std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(mut);
+
+        if (!quota.reserve(client, memory)) {
+            return retryAfter();
+        }
+
+        pendingCost += cost;
+
+        const std::chrono::duration<double, std::milli> now = std::chrono::steady_clock::now() - created;
+        jobs.push({ now.count() + static_cast<double>(cost) / COST_UNITS_PER_MS, submitted++, client, cost, memory, std::move(task) });
+    }
+
+    cv.notify_one();
+    return 0;
+}
+
+void Scheduler::release(const uint32_t client) {
+    finish(client, 0, 0);
+}
+
+void Scheduler::printStats() {
+    std::unique_lock<std::mutex> lock(mut);
+    printNodeStats();
+}
+
+void Scheduler::printNodeStats() const {
+    const std::chrono::duration<double, std::milli> uptime = std::chrono::steady_clock::now() - created;
+
+    //node -> (workers, jobs, busy time)
+    std::map<int, std::tuple<unsigned, uint64_t, double>> nodes;
+
+    for (const workerStats& worker : stats) {
+        auto& [workers, jobs, busyMs] = nodes[worker.node];
+        ++workers;
+        jobs += worker.jobs;
+        busyMs += worker.busyMs;
+    }
+
+    for (const auto& [node, totals] : nodes) {
+        const auto& [workers, jobs, busyMs] = totals;
+
+        std::cout << (node < 0 ? "Unpinned workers" : "NUMA node " + std::to_string(node)) << ": " << workers
+            << " worker/s, " << jobs << " request/s, " << std::round(1000 * busyMs / (workers * uptime.count())) / 10 
+            << "% busy\n";
+    }
+}
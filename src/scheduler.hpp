@@ -0,0 +1,83 @@
+#pragma once
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "quota.hpp"
+
+#define MAX_QUEUED_MS 30000
+#define COST_UNITS_PER_MS 100000
+#define STATS_INTERVAL_MS 60000
+
+// Runs requests on a fixed number of workers, shortest estimated job first.
+// A job's priority is its virtual finish time, arrival + estimated duration, so long jobs are
+// overtaken by short ones only until newer arrivals' finish times pass theirs, and cannot starve.
+// Clients are identified by address and limited in concurrent requests and memory through a ClientQuota, which may be
+// shared with other server processes. The MAX_QUEUED_MS backlog limit applies to this scheduler's own queue.
+class Scheduler {
+    struct job {
+        double finish;
+        uint64_t order;
+        uint32_t client;
+        uint64_t cost;
+        uint64_t memory;
+        std::function<void()> task;
+
+        bool operator<(const job& other) const {
+            return finish > other.finish || (finish == other.finish && order > other.order);
+        }
+    };
+
+    struct workerStats {
+        int node = -1; // NUMA node the worker is pinned to, -1 if it is not pinned
+        uint64_t jobs = 0;
+        double busyMs = 0;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<workerStats> stats;
+    std::priority_queue<job> jobs;
+    ClientQuota& quota;
+    uint64_t pendingCost = 0; // estimated cost of queued and running jobs
+    uint64_t submitted = 0;
+    const std::chrono::steady_clock::time_point created = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastReport = created;
+    std::mutex mut;
+    std::condition_variable cv;
+    bool running = true;
+
+    unsigned retryAfter() const;
+    void printNodeStats() const;
+    void finish(const uint32_t client, const uint64_t cost, const uint64_t memory);
+
+public:
+
+    // With pin, worker i runs only on the CPUs of the (i % nodes)th NUMA node the process may use,
+    // together with every thread it starts.
+    Scheduler(size_t n, ClientQuota& quota, const bool pin = false);
+    ~Scheduler();
+
+    // Registers a new connection. Returns 0 if it is admitted, otherwise the seconds to wait before retrying.
+    unsigned admit(const uint32_t client);
+
+    // Queues an admitted client's request. Returns 0 if it is accepted, otherwise the seconds to wait before
+    // retrying, in which case the connection is released.
+    unsigned submit(const uint32_t client, const uint64_t cost, const uint64_t memory, std::function<void()> task);
+
+    // Releases an admitted connection that did not submit a request.
+    void release(const uint32_t client);
+
+    // Prints the requests served and the share of time the workers were busy since the start, per NUMA node.
+    // Workers also print this every STATS_INTERVAL_MS while requests are being served.
+    void printStats();
+};
+
+#endif
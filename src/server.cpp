@@ -1,67 +1,301 @@
+#include <algorithm>
 #include <bit>
 #include <chrono>
 #include <errno.h>
 #include <iostream>
+#include <memory>
 #include <cstring>
 #include <csignal>
+#include <cstdlib>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <unordered_map>
 #include <unistd.h>
+#include "affinity.hpp"
+#include "eppstein.hpp"
 #include "io.hpp"
+#include "reorder.hpp"
+#include "scheduler.hpp"
 #include "threadpool.hpp"
 #include "yen.hpp"
 
 #define MAX_USERS 4
+#define REORDER_MIN_VERTICES 4096
 
-const uint32_t MAX_THREADS = std::max(std::thread::hardware_concurrency() / MAX_USERS * 3 / 2, 1u);
+uint32_t maxThreads = 1; // threads a request may use, set by serve() from the CPUs the process may run on
 bool running = true;
+bool pinCompute = false;
+bool reorderGraphs = false;
+memoryPlacement graphPlacement = memoryPlacement::firstTouch;
 
 void interruptHandler(int signum) {
     running = false;
     std::cout << "Closing the server...\n";
 }
 
-void serveClient(const int clientFd) {
-    std::vector<std::vector<edge>> graph;
-    uint32_t start, end, k, threads;
+template <typename V, typename W>
+graph_t<V, W> narrowGraph(graph_t<uint32_t, uint32_t>& graph) {
+    graph_t<V, W> result(graph.size());
+
+    for (size_t i = 0; i < graph.size(); ++i) {
+        result[i].reserve(graph[i].size());
+
+        for (const edge<uint32_t, uint32_t>& e : graph[i]) {
+            result[i].push_back({ static_cast<V>(e.first), static_cast<W>(e.second) });
+        }
+
+        graph[i] = {};
+    }
+
+    return result;
+}
+
+// Narrowing copies the graph on the computing thread, which places the copy on its node unless interleaving.
+template <typename V, typename W>
+graph_t<V, W> placeGraph(graph_t<uint32_t, uint32_t>& graph) {
+    const bool interleave = graphPlacement == memoryPlacement::interleave;
+
+    if (interleave) {
+        interleaveAllocations(true);
+    }
+
+    graph_t<V, W> result = narrowGraph<V, W>(graph);
+
+    if (interleave) {
+        interleaveAllocations(false);
+    }
+
+    return result;
+}
+
+typedef std::function<void(const size_t, std::vector<path>&)> resultHandler;
+
+template <typename V, typename W>
+void runSearch(const graph_t<V, W>& graph, const uint32_t start, const std::vector<uint32_t>& ends, const uint32_t k, 
+    const uint32_t threads, const searchAlgorithm algorithm, const bool wideCosts, resultHandler onResult) {
+    std::vector<V> narrowEnds(ends.begin(), ends.end());
+
+    if (algorithm == searchAlgorithm::walks) {
+        eppsteinToMany<V, W>(graph, start, narrowEnds, k, threads, onResult);
+    } else if (wideCosts) {
+        yenToMany<V, W, uint64_t>(graph, start, narrowEnds, k, threads, onResult);
+    } else {
+        yenToMany<V, W, uint32_t>(graph, start, narrowEnds, k, threads, onResult);
+    }
+}
+
+// Picks the narrowest vertex, weight and distance types that are safe for the graph.
+// The maximum vertex ID and the maximum distance are reserved as sentinels.
+void dispatchSearch(graph_t<uint32_t, uint32_t>& graph, const uint32_t start, const std::vector<uint32_t>& ends, 
+    const uint32_t k, const uint32_t threads, const searchAlgorithm algorithm, resultHandler onResult) {
+    uint64_t maxWeight = 0;
+
+    for (const std::vector<edge<uint32_t, uint32_t>>& neighbours : graph) {
+        for (const edge<uint32_t, uint32_t>& e : neighbours) {
+            maxWeight = std::max<uint64_t>(maxWeight, e.second);
+        }
+    }
+
+    const bool smallIds = graph.size() <= UINT16_MAX;
+    const bool smallWeights = maxWeight <= UINT16_MAX;
+    //a relaxation adds one more edge to a loopless path, so tentative distances reach up to N * w_max
+    const bool wideCosts = graph.size() * maxWeight >= UINT32_MAX;
+
+    if (smallIds && smallWeights) {
+        runSearch(placeGraph<uint16_t, uint16_t>(graph), start, ends, k, threads, algorithm, wideCosts, onResult);
+    } else if (smallIds) {
+        runSearch(placeGraph<uint16_t, uint32_t>(graph), start, ends, k, threads, algorithm, wideCosts, onResult);
+    } else if (smallWeights) {
+        runSearch(placeGraph<uint32_t, uint16_t>(graph), start, ends, k, threads, algorithm, wideCosts, onResult);
+    } else if (graphPlacement == memoryPlacement::local) {
+        runSearch(narrowGraph<uint32_t, uint32_t>(graph), start, ends, k, threads, algorithm, wideCosts, onResult);
+    } else {
+        runSearch(graph, start, ends, k, threads, algorithm, wideCosts, onResult);
+    }
+}
+
+struct clientRequest {
+    graph_t<uint32_t, uint32_t> graph;
+    std::vector<uint32_t> ends;
+    uint32_t start, k, threads;
+    searchAlgorithm algorithm;
+};
+
+// Sends the client the reason its request was rejected and closes the connection.
+void sendError(const int clientFd, const char* message) {
+    if (send32<int32_t>(clientFd, -1) < 0 || write(clientFd, message, strlen(message)) < 0) {
+        perror("write");
+    }
+
+    close(clientFd);
+}
+
+// Reads and validates a request. On failure the client is sent the reason and the connection is closed.
+// Graphs that could not fit in a client's memory quota, and more end vertices than the graph has,
+// are rejected while their size is being read.
+bool readRequest(const int clientFd, clientRequest& request) {
+    graph_t<uint32_t, uint32_t>& graph = request.graph;
+    std::vector<uint32_t>& ends = request.ends;
+    uint32_t& start = request.start;
+    uint32_t& k = request.k;
+    uint32_t& threads = request.threads;
+    uint32_t algorithm;
+    bool tooLarge = false;
+    bool tooManyEnds = false;
+
+    if (!readGraph(clientFd, graph, MAX_CLIENT_MEMORY, &tooLarge) || !read32<uint32_t>(clientFd, &start) 
+        || !readPath(clientFd, ends, graph.size(), &tooManyEnds) || !read32<uint32_t>(clientFd, &k) 
+        || !read32<uint32_t>(clientFd, &threads) || !read32<uint32_t>(clientFd, &algorithm)) {
+        if (tooLarge) {
+            sendError(clientFd, "The request needs more memory than the server allows!\n");
+            return false;
+        }
+
+        if (tooManyEnds) {
+            sendError(clientFd, "There are more end vertices than vertices in the graph!\n");
+            return false;
+        }
 
-    if (!readGraph(clientFd, graph) || !read32<uint32_t>(clientFd, &start) || !read32<uint32_t>(clientFd, &end) 
-        || !read32<uint32_t>(clientFd, &k) || !read32<uint32_t>(clientFd, &threads)) {
         std::cout << "An error occured.\n";
         close(clientFd);
-        return;
+        return false;
     }
 
     bool error = false;
     const char* message;
 
-    if (start >= graph.size() || end >= graph.size()) {
+    if (start >= graph.size() || std::any_of(ends.begin(), ends.end(), [&](uint32_t end) { return end >= graph.size(); })) {
         error = true;
         message = "Start or end is not a valid vertex!\n";
     }
 
+    if (!error && ends.empty()) {
+        error = true;
+        message = "At least one end vertex is required!\n";
+    }
+
     if (!error && k == 0) {
         error = true;
         message = "K must be at least 1!\n";
     }
 
-    if (!error && (threads == 0 || threads > MAX_THREADS)) {
+    if (!error && (threads == 0 || threads > maxThreads)) {
         error = true;
         message = "Invalid thread count!\n";
     }
 
-    if (error && (send32<int32_t>(clientFd, -1) < 0 || write(clientFd, message, strlen(message)) < 0)) {
+    if (!error && algorithm > static_cast<uint32_t>(searchAlgorithm::walks)) {
+        error = true;
+        message = "Unknown search algorithm!\n";
+    }
+
+    request.algorithm = static_cast<searchAlgorithm>(algorithm);
+
+    if (error) {
+        sendError(clientFd, message);
+        return false;
+    }
+
+    return true;
+}
+
+size_t edgeCount(const graph_t<uint32_t, uint32_t>& graph) {
+    size_t edges = 0;
+
+    for (const std::vector<edge<uint32_t, uint32_t>>& neighbours : graph) {
+        edges += neighbours.size();
+    }
+
+    return edges;
+}
+
+// Rough work estimate: for loopless paths every target needs about K rounds of searches over the whole graph,
+// for walks a single search plus a heap operation per walk.
+uint64_t estimateCost(const clientRequest& request) {
+    const double vertices = request.graph.size();
+    const double search = edgeCount(request.graph) + vertices * std::bit_width(request.graph.size());
+    const double perTarget = request.algorithm == searchAlgorithm::walks 
+        ? search + static_cast<double>(request.k) * std::bit_width(request.k) : search * request.k;
+
+    return std::min(static_cast<double>(UINT64_MAX / 2), perTarget * request.ends.size());
+}
+
+// The graph, plus distances, predecessors and a heap for every concurrent search.
+// Loopless paths also need the CSR copy of the graph used by sequential searches (offsets, targets and weights).
+// Walks also need the reversed graph and a sidetrack heap with about one node per edge for every concurrent target.
+// Every result is kept until its target is done: at least a path with its costs (loopless), or a walk,
+// its record and the heap candidates it adds (walks), whatever the graph.
+uint64_t estimateMemory(const clientRequest& request) {
+    const uint64_t graphBytes = edgeCount(request.graph) * sizeof(edge<uint32_t, uint32_t>) 
+        + request.graph.size() * sizeof(std::vector<edge<uint32_t, uint32_t>>);
+    const uint64_t searchBytes = static_cast<uint64_t>(request.threads) * request.graph.size() * 24;
+    const uint64_t concurrentTargets = std::min<uint64_t>(request.threads, request.ends.size());
+
+    if (request.algorithm == searchAlgorithm::walks) {
+        const uint64_t heapBytes = (edgeCount(request.graph) + request.graph.size() * std::bit_width(request.graph.size())) * 24;
+        const uint64_t resultBytes = static_cast<uint64_t>(request.k) * (sizeof(path) + sizeof(uint32_t) + 16 + 3 * 24);
+
+        return 3 * graphBytes + searchBytes + concurrentTargets * (heapBytes + resultBytes);
+    }
+
+    const uint64_t csrBytes = (request.graph.size() + 1) * sizeof(size_t) + edgeCount(request.graph) * 2 * sizeof(uint32_t);
+    const uint64_t resultBytes = static_cast<uint64_t>(request.k) * (sizeof(path) + sizeof(std::vector<uint64_t>) 
+        + std::min<uint64_t>(request.graph.size(), 2) * (sizeof(uint32_t) + sizeof(uint64_t)));
+
+    return graphBytes + csrBytes + searchBytes + concurrentTargets * resultBytes;
+}
+
+void sendRetryAfter(const int clientFd, const unsigned seconds) {
+    if (send32<int32_t>(clientFd, -2) < 0 || send32<uint32_t>(clientFd, seconds) < 0) {
         perror("write");
-        close(clientFd);
-        return;
     }
 
+    close(clientFd);
+}
+
+void solveRequest(const int clientFd, clientRequest& request) {
+    graph_t<uint32_t, uint32_t>& graph = request.graph;
+    std::vector<uint32_t>& ends = request.ends;
+    uint32_t start = request.start;
+    const uint32_t k = request.k;
+    const uint32_t threads = request.threads;
+
     const auto startTime = std::chrono::high_resolution_clock::now();
-    std::vector<path> paths = yen(graph, start, end, k, threads);
+
+    //renumbering costs several searches' worth of time, and graphs are not kept between requests, so it is only
+    //repaid by loopless requests with K > 1, which run at least one spur search per vertex of the first path;
+    //small graphs fit in cache anyway
+    const bool reorder = reorderGraphs && request.algorithm == searchAlgorithm::loopless && k > 1
+        && graph.size() >= REORDER_MIN_VERTICES;
+    vertexOrder order;
+
+    if (reorder) {
+        order = reorderGraph(graph);
+        start = order.toNew[start];
+
+        for (uint32_t& end : ends) {
+            end = order.toNew[end];
+        }
+    }
+
+    //results are streamed as [target index][paths] in the order the targets finish
+    std::mutex sendMutex;
+    bool sent = true;
+
+    dispatchSearch(graph, start, ends, k, threads, request.algorithm, [&](const size_t target, std::vector<path>& paths) {
+        if (reorder) {
+            restorePaths(paths, order);
+        }
+
+        std::unique_lock<std::mutex> lock(sendMutex);
+        sent = sent && send32<uint32_t>(clientFd, target) >= 0 && sendPaths(clientFd, paths);
+    });
+
     const auto endTime = std::chrono::high_resolution_clock::now();
 
-    if (!sendPaths(clientFd, paths)) {
+    if (!sent) {
         std::cout << "An error occured.\n";
         close(clientFd);
         return;
@@ -77,12 +311,37 @@ void serveClient(const int clientFd) {
     close(clientFd);
 }
 
-int main() {
-    if (signal(SIGINT, interruptHandler) == SIG_ERR || signal(SIGPIPE, SIG_IGN) == SIG_ERR) {
-        perror("signal");
-        return -1;
+void serveClient(const int clientFd, const uint32_t client, Scheduler& scheduler) {
+    std::shared_ptr<clientRequest> request = std::make_shared<clientRequest>();
+
+    if (!readRequest(clientFd, *request)) {
+        scheduler.release(client);
+        return;
+    }
+
+    const uint64_t memory = estimateMemory(*request);
+
+    if (memory > MAX_CLIENT_MEMORY) {
+        sendError(clientFd, "The request needs more memory than the server allows!\n");
+        scheduler.release(client);
+        return;
+    }
+
+    unsigned retryAfter = scheduler.submit(client, estimateCost(*request), memory, [clientFd, request]() {
+        solveRequest(clientFd, *request);
+    });
+
+    if (retryAfter) {
+        sendRetryAfter(clientFd, retryAfter);
     }
-    
+}
+
+// Accepts and serves clients until SIGINT. Sharded servers share the port through SO_REUSEPORT,
+// letting the kernel balance incoming connections between their listeners, and the per-client quota.
+// siblings is the number of server processes running on the same CPUs as this one, which split them.
+int serve(const bool sharded, ClientQuota& quota, const unsigned siblings) {
+    maxThreads = std::max(allowedCpuCount() * 3 / (2 * MAX_USERS * siblings), 1u);
+
     int s = socket(AF_INET, SOCK_STREAM, 0);
 
     if (s < 0) {
@@ -91,7 +350,8 @@ int main() {
     }
 
     int reuse = 1;
-    if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const void*) &reuse, sizeof(reuse)) < 0) {
+    if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const void*) &reuse, sizeof(reuse)) < 0
+        || (sharded && setsockopt(s, SOL_SOCKET, SO_REUSEPORT, (const void*) &reuse, sizeof(reuse)) < 0)) {
         perror("setsockopt");
         close(s);
         return -1;
@@ -111,7 +371,14 @@ int main() {
         return -1;
     }
 
-    Threadpool tpool(MAX_USERS);
+    //requests are read by tpool and computed by the scheduler, which must outlive it
+    Scheduler scheduler(MAX_USERS, quota, pinCompute);
+    Threadpool tpool(MAX_USERS, [](size_t) {
+        if (graphPlacement == memoryPlacement::interleave) {
+            interleaveAllocations(true);
+        }
+    });
+    std::unordered_map<int, uint32_t> clientAddrs;
 
     fd_set readFds, writeFds;
     FD_ZERO(&readFds);
@@ -145,7 +412,8 @@ int main() {
             if (FD_ISSET(i, &readFdsReady)) {
                 if (i != s) {
                     FD_CLR(i, &readFds);
-                    tpool.enqueue(std::bind(serveClient, i));
+                    tpool.enqueue(std::bind(serveClient, i, clientAddrs[i], std::ref(scheduler)));
+                    clientAddrs.erase(i);
                     continue;
                 }
 
@@ -159,6 +427,7 @@ int main() {
                 }
 
                 FD_SET(clientFd, &writeFds);
+                clientAddrs[clientFd] = ntohl(clientAddr.sin_addr.s_addr);
                 maxFd = std::max(maxFd, clientFd);
             } else if (FD_ISSET(i, &readFds)) {
                 maxFd = std::max(maxFd, i);
@@ -167,9 +436,24 @@ int main() {
             if (FD_ISSET(i, &writeFdsReady)) {
                 FD_CLR(i, &writeFds);
 
-                if (send32<uint32_t>(i, MAX_THREADS) < 0) {
+                //overloaded servers and busy clients are turned away before they upload anything
+                unsigned retryAfter = scheduler.admit(clientAddrs[i]);
+
+                if (retryAfter) {
+                    if (send32<uint32_t>(i, 0) < 0 || send32<uint32_t>(i, retryAfter) < 0) {
+                        perror("write");
+                    }
+
+                    close(i);
+                    clientAddrs.erase(i);
+                    continue;
+                }
+
+                if (send32<uint32_t>(i, maxThreads) < 0) {
                     perror("write");
                     close(i);
+                    scheduler.release(clientAddrs[i]);
+                    clientAddrs.erase(i);
                     continue;
                 }
                 
@@ -180,5 +464,148 @@ int main() {
     }
 
     close(s);
+    scheduler.printStats();
     return 0;
-}
\ No newline at end of file
+}
+
+int main(int argc, char** argv) {
+    if (signal(SIGINT, interruptHandler) == SIG_ERR || signal(SIGPIPE, SIG_IGN) == SIG_ERR) {
+        perror("signal");
+        return -1;
+    }
+
+    //-p N: fork N worker processes, each with its own listener; -n: pin each worker process to a NUMA node
+    //-c: pin compute threads to NUMA nodes round-robin; -g local|interleave: where received graphs are placed
+    //-r: renumber big graphs for locality before searching them
+    unsigned processes = 1;
+    bool pinNuma = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:ncg:r")) != -1) {
+        if (opt == 'p' && atoi(optarg) > 0) {
+            processes = atoi(optarg);
+        } else if (opt == 'n') {
+            pinNuma = true;
+        } else if (opt == 'c') {
+            pinCompute = true;
+        } else if (opt == 'r') {
+            reorderGraphs = true;
+        } else if (opt == 'g' && strcmp(optarg, "local") == 0) {
+            graphPlacement = memoryPlacement::local;
+        } else if (opt == 'g' && strcmp(optarg, "interleave") == 0) {
+            graphPlacement = memoryPlacement::interleave;
+        } else {
+            std::cout << "Usage: " << argv[0] << " [-p processes] [-n] [-c] [-g local|interleave] [-r]\n";
+            return -1;
+        }
+    }
+
+    //probed once here, so requests need not check set_mempolicy() every time
+    if (graphPlacement == memoryPlacement::interleave && (!interleaveAllocations(true) || !interleaveAllocations(false))) {
+        std::cout << "NUMA interleaving is not available, graphs are placed on first touch instead.\n";
+        graphPlacement = memoryPlacement::firstTouch;
+    }
+
+    const unsigned nodes = numaNodeCount();
+
+    //mapped before forking, so every worker process enforces the same per-client limits
+    ClientQuota quota;
+
+    if (processes == 1) {
+        if (pinNuma && !pinToNumaNode(0)) {
+            std::cout << "Could not pin the server to NUMA node 0.\n";
+        }
+
+        return serve(false, quota, 1);
+    }
+
+    //the supervisor must not restart waitpid() after SIGINT, so it can shut the workers down
+    struct sigaction interrupt = {};
+    interrupt.sa_handler = interruptHandler;
+
+    if (sigaction(SIGINT, &interrupt, nullptr) < 0) {
+        perror("sigaction");
+        return -1;
+    }
+
+    std::vector<pid_t> workers(processes, -1);
+
+    auto spawn = [&](const unsigned i) {
+        //otherwise the worker inherits and prints the supervisor's buffered output again
+        std::cout.flush();
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            perror("fork");
+            return false;
+        }
+
+        if (pid == 0) {
+            if (signal(SIGINT, interruptHandler) == SIG_ERR) {
+                perror("signal");
+                exit(-1);
+            }
+
+            if (pinNuma && !pinToNumaNode(i % nodes)) {
+                std::cout << "Could not pin worker " << i << " to NUMA node " << i % nodes << ".\n";
+            }
+
+            //with -n, workers i, i + nodes, ... share a node's CPUs, otherwise all of them share every CPU
+            const unsigned siblings = pinNuma ? (processes - i % nodes + nodes - 1) / nodes : processes;
+
+            quota.setOwner(i);
+            exit(serve(true, quota, siblings));
+        }
+
+        workers[i] = pid;
+        return true;
+    };
+
+    for (unsigned i = 0; i < processes && running; ++i) {
+        if (!spawn(i)) {
+            running = false;
+        }
+    }
+
+    //a crashed worker only loses its own clients and is replaced
+    while (running) {
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+
+        if (pid < 0) {
+            if (errno == ECHILD) {
+                std::cout << "All workers have stopped.\n";
+                running = false;
+            } else if (errno != EINTR) {
+                perror("waitpid");
+                running = false;
+            }
+
+            continue;
+        }
+
+        unsigned i = std::find(workers.begin(), workers.end(), pid) - workers.begin();
+
+        if (i == processes) {
+            continue;
+        }
+
+        workers[i] = -1;
+        quota.releaseOwner(i);
+
+        if (WIFSIGNALED(status) && WTERMSIG(status) != SIGINT) {
+            std::cout << "Worker " << i << " stopped unexpectedly, restarting it...\n";
+            spawn(i);
+        }
+    }
+
+    for (pid_t pid : workers) {
+        if (pid > 0) {
+            kill(pid, SIGINT);
+        }
+    }
+
+    while (waitpid(-1, nullptr, 0) > 0 || errno == EINTR);
+
+    return 0;
+}
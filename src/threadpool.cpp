@@ -1,8 +1,12 @@
 #include "threadpool.hpp"
 
-Threadpool::Threadpool(size_t n) {
+Threadpool::Threadpool(size_t n, std::function<void(size_t)> init) {
     for (size_t i = 0; i < n; ++i) {
-        threads.emplace_back([this] {
+        threads.emplace_back([this, i, init] {
+            if (init) {
+                init(i);
+            }
+
             while (true) {
                 std::function<void()> task;
 
@@ -22,7 +22,8 @@ class Threadpool {
 
 public:
 
-    Threadpool(size_t n = std::thread::hardware_concurrency());
+    // init is called on every worker thread with its index before it takes any tasks.
+    Threadpool(size_t n = std::thread::hardware_concurrency(), std::function<void(size_t)> init = nullptr);
     ~Threadpool();
 
     template <typename F>
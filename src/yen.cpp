@@ -1,17 +1,24 @@
 #include <algorithm>
-#include <climits>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <optional>
 #include <queue>
 #include <stdexcept>
 #include <unordered_set>
+#include "relax.hpp"
 #include "threadpool.hpp"
 #include "yen.hpp"
 
+#define PARALLEL_SEARCH_MIN_VERTICES (1 << 16)
+
+template <typename V>
 struct edgeHash {
-    size_t operator()(const edge& e) const {
-        size_t hash1 = std::hash<unsigned>{}(e.first);
-        size_t hash2 = std::hash<unsigned>{}(e.second);
+    size_t operator()(const edgeKey<V>& e) const {
+        size_t hash1 = std::hash<V>{}(e.first);
+        size_t hash2 = std::hash<V>{}(e.second);
 
         return hash1 ^ (hash2 + 0x9e3779b9 + (hash1 << 6) + (hash1 >> 2));
     }
@@ -29,11 +36,12 @@ struct pathHash {
     }
 };
 
+template <typename D>
 struct pathWithCost {
     path pathNodes;
-    std::vector<unsigned> cumulativeCost;
+    std::vector<D> cumulativeCost;
 
-    unsigned getTotalCost() const {
+    D getTotalCost() const {
         return cumulativeCost[cumulativeCost.size() - 1];
     }
 
@@ -42,32 +50,54 @@ struct pathWithCost {
     }
 };
 
-std::vector<unsigned> dijkstra(const std::vector<std::vector<edge>>& graph, const unsigned start, 
-    std::vector<unsigned>* prev, std::function<bool(const edge&)> filter) {
+// CSR copy of a graph, built by the first search that needs it. Searches that all run in parallel
+// (delta-stepping) never do, so they do not pay for a second copy of the adjacency lists.
+template <typename V, typename W>
+class lazyCsr {
+    const graph_t<V, W>& graph;
+    std::optional<csrGraph<V, W>> csr;
+    std::once_flag built;
+
+public:
+    lazyCsr(const graph_t<V, W>& graph) : graph(graph) {}
+
+    const csrGraph<V, W>& get() {
+        std::call_once(built, [this] {
+            csr.emplace(graph);
+        });
+
+        return *csr;
+    }
+};
+
+template <typename V, typename W, typename D>
+std::vector<D> dijkstra(const graph_t<V, W>& graph, const V start,
+    std::vector<V>* prev, std::function<bool(const edgeKey<V>&)> filter) {
     if (start > graph.size() - 1) {
         throw std::invalid_argument("Provided start is not a vertex in the graph.");
     }
 
-    std::vector<unsigned> dist(graph.size(), INT_MAX);
+    std::vector<D> dist(graph.size(), std::numeric_limits<D>::max());
     dist[start] = 0;
 
     if (prev) {
-        *prev = std::vector<unsigned>(graph.size(), INT_MAX);
+        *prev = std::vector<V>(graph.size(), std::numeric_limits<V>::max());
     }
 
-    std::priority_queue<edge, std::vector<edge>, std::greater<edge>> pq;
+    typedef std::pair<D, V> entry;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> pq;
     pq.push({ dist[start], start });
 
     while (!pq.empty()) {
-        unsigned v = pq.top().second;
-        unsigned d = pq.top().first;
+        V v = pq.top().second;
+        D d = pq.top().first;
         pq.pop();
 
         if (d > dist[v]) {
             continue;
         }
 
-        for (const edge& neighbour : graph[v]) {
+        for (const edge<V, W>& neighbour : graph[v]) {
             if (filter && !filter({ v, neighbour.first })) {
                 continue;
             }
@@ -88,13 +118,152 @@ std::vector<unsigned> dijkstra(const std::vector<std::vector<edge>>& graph, cons
     return dist;
 }
 
-pathWithCost dijkstra_to(const std::vector<std::vector<edge>>& graph, const unsigned start, 
-    unsigned end, std::function<bool(const edge&)> filter = nullptr) {
-    std::vector<unsigned> prev;
-    std::vector<unsigned> dist = dijkstra(graph, start, &prev, filter);
+// Parallel bucket-based (delta-stepping) variant of dijkstra() for searches on big graphs.
+// Every phase relaxes a whole bucket: workers generate relaxation requests for their slice of the bucket,
+// then each worker applies the requests for the vertices it owns (v % workers), so no locks are needed.
+template <typename V, typename W, typename D>
+std::vector<D> deltaStepping(const graph_t<V, W>& graph, const V start, const W maxWeight, Threadpool& tpool,
+    const unsigned workers, std::vector<V>* prev = nullptr, std::function<bool(const edgeKey<V>&)> filter = nullptr) {
+    if (start > graph.size() - 1) {
+        throw std::invalid_argument("Provided start is not a vertex in the graph.");
+    }
+
+    size_t edges = 0;
+    for (const std::vector<edge<V, W>>& neighbours : graph) {
+        edges += neighbours.size();
+    }
+
+    //edges up to delta are light and may be relaxed repeatedly within a bucket, heavier ones only once
+    const D delta = std::max<D>(1, maxWeight / std::max<size_t>(1, edges / graph.size()));
+    const size_t bucketCount = maxWeight / delta + 2;
+
+    std::vector<D> dist(graph.size(), std::numeric_limits<D>::max());
+    std::vector<V> parent(prev ? graph.size() : 0, std::numeric_limits<V>::max());
+    dist[start] = 0;
+
+    struct request {
+        V to;
+        V from;
+        D dist;
+    };
+
+    //requests[generating worker][owning worker]
+    std::vector<std::vector<std::vector<request>>> requests(workers, std::vector<std::vector<request>>(workers));
+    std::vector<std::vector<V>> reached(workers);
+    std::vector<std::vector<V>> buckets(bucketCount);
+    buckets[0].push_back(start);
+
+    auto relax = [&](const std::vector<V>& vertices, const bool light) {
+        const size_t chunk = (vertices.size() + workers - 1) / workers;
+
+        for (unsigned w = 0; w < workers; ++w) {
+            tpool.enqueue([&, w]() {
+                for (size_t i = w * chunk; i < std::min(vertices.size(), (w + 1) * chunk); ++i) {
+                    const V v = vertices[i];
+
+                    for (const edge<V, W>& neighbour : graph[v]) {
+                        if ((neighbour.second <= delta) != light || (filter && !filter({ v, neighbour.first }))) {
+                            continue;
+                        }
+
+                        const D d = dist[v] + neighbour.second;
+
+                        if (d < dist[neighbour.first]) {
+                            requests[w][neighbour.first % workers].push_back({ neighbour.first, v, d });
+                        }
+                    }
+                }
+            });
+        }
+
+        tpool.wait_finished();
+
+        for (unsigned owner = 0; owner < workers; ++owner) {
+            tpool.enqueue([&, owner]() {
+                for (unsigned w = 0; w < workers; ++w) {
+                    for (const request& r : requests[w][owner]) {
+                        if (r.dist < dist[r.to]) {
+                            dist[r.to] = r.dist;
+                            reached[owner].push_back(r.to);
+
+                            if (prev) {
+                                parent[r.to] = r.from;
+                            }
+                        }
+                    }
+
+                    requests[w][owner].clear();
+                }
+            });
+        }
+
+        tpool.wait_finished();
+
+        for (std::vector<V>& vertices : reached) {
+            for (V v : vertices) {
+                buckets[dist[v] / delta % bucketCount].push_back(v);
+            }
+
+            vertices.clear();
+        }
+    };
+
+    //marks vertices already taken into the current frontier; stale bucket entries are skipped
+    std::vector<unsigned> stamp(graph.size(), 0);
+    unsigned round = 0;
+
+    auto takeUnique = [&](std::vector<V>& vertices, const D bucket) {
+        ++round;
+        vertices.erase(std::remove_if(vertices.begin(), vertices.end(), [&](const V v) {
+            if (dist[v] / delta != bucket || stamp[v] == round) {
+                return true;
+            }
+
+            stamp[v] = round;
+            return false;
+        }), vertices.end());
+    };
+
+    D current = 0;
+
+    while (true) {
+        size_t scanned = 0;
+        while (scanned < bucketCount && buckets[current % bucketCount].empty()) {
+            ++current;
+            ++scanned;
+        }
+
+        if (scanned == bucketCount) {
+            break;
+        }
+
+        std::vector<V> settled;
+
+        while (!buckets[current % bucketCount].empty()) {
+            std::vector<V> frontier;
+            frontier.swap(buckets[current % bucketCount]);
+            takeUnique(frontier, current);
+
+            settled.insert(settled.end(), frontier.begin(), frontier.end());
+            relax(frontier, true);
+        }
+
+        takeUnique(settled, current);
+        relax(settled, false);
+        ++current;
+    }
+
+    if (prev) {
+        *prev = std::move(parent);
+    }
+
+    return dist;
+}
 
-    pathWithCost result;
-    while (end != INT_MAX) {
+template <typename V, typename D>
+pathWithCost<D> buildPath(const std::vector<D>& dist, const std::vector<V>& prev, V end) {
+    pathWithCost<D> result;
+    while (end != std::numeric_limits<V>::max()) {
         result.pathNodes.push_back(end);
         end = prev[end];
     }
@@ -108,38 +277,55 @@ pathWithCost dijkstra_to(const std::vector<std::vector<edge>>& graph, const unsi
     return result;
 }
 
-std::vector<path> yen(const std::vector<std::vector<edge>>& graph, const unsigned start, 
-    const unsigned end, const unsigned k, const unsigned threads) {
-    if (start > graph.size() - 1 || end > graph.size() - 1) {
-        throw std::invalid_argument("Provided start or end is not a vertex in the graph.");
-    }
+template <typename V, typename W, typename D>
+pathWithCost<D> csr_dijkstra_to(const csrGraph<V, W>& graph, const V start, V end, 
+    const std::vector<uint32_t>& banned, const std::vector<V>& bannedFromStart) {
+    std::vector<V> prev;
+    std::vector<D> dist = csrDijkstra<V, W, D>(graph, start, banned, bannedFromStart, prev);
 
-    if (k == 0) {
-        throw std::invalid_argument("Invalid K! Must be at least 1.");
-    }
+    return buildPath(dist, prev, end);
+}
 
-    std::vector<path> kth_path;
-    kth_path.reserve(k);
-    std::vector<std::vector<unsigned>> kth_cost(k);
+template <typename V, typename W, typename D>
+pathWithCost<D> parallel_dijkstra_to(const graph_t<V, W>& graph, const V start, V end, const W maxWeight,
+    Threadpool& tpool, const unsigned workers, std::function<bool(const edgeKey<V>&)> filter = nullptr) {
+    std::vector<V> prev;
+    std::vector<D> dist = deltaStepping<V, W, D>(graph, start, maxWeight, tpool, workers, &prev, filter);
 
-    pathWithCost path0 = dijkstra_to(graph, start, end);
+    return buildPath(dist, prev, end);
+}
 
-    if (path0.getTotalCost() >= INT_MAX) {
-        return {};
+template <typename V, typename W>
+W maxEdgeWeight(const graph_t<V, W>& graph) {
+    W maxWeight = 0;
+
+    for (const std::vector<edge<V, W>>& neighbours : graph) {
+        for (const edge<V, W>& e : neighbours) {
+            maxWeight = std::max(maxWeight, e.second);
+        }
     }
 
-    kth_path.push_back(path0.pathNodes);
-    kth_cost[0] = path0.cumulativeCost;
+    return maxWeight;
+}
+
+// Yen's iterations, starting from an already known shortest path to end.
+// Spur searches run on tpool if there is one, inline otherwise.
+template <typename V, typename W, typename D>
+std::vector<path> yenFrom(const graph_t<V, W>& graph, lazyCsr<V, W>& csr, const pathWithCost<D>& path0, 
+    const V end, const unsigned k, Threadpool* tpool, const unsigned threads, const W maxWeight) {
+    //grown as paths are found rather than reserved for K, which is client-controlled and may never be reached
+    std::vector<path> kth_path = { path0.pathNodes };
+    std::vector<std::vector<D>> kth_cost = { path0.cumulativeCost };
 
-    std::priority_queue<pathWithCost> candidate_paths;
-    std::unordered_set<path, pathHash> candidates_set;
+    const bool parallelSearch = tpool && graph.size() >= PARALLEL_SEARCH_MIN_VERTICES;
 
-    Threadpool tpool(threads);
+    std::priority_queue<pathWithCost<D>> candidate_paths;
+    std::unordered_set<path, pathHash> candidates_set;
     std::mutex candidates_mutex;
 
     for (unsigned curr_k = 1; curr_k < k; ++curr_k) {
         path prev_path = kth_path[curr_k - 1];
-        std::vector<std::unordered_set<edge, edgeHash>> banned_edges(prev_path.size() - 1);
+        std::vector<std::unordered_set<edgeKey<V>, edgeHash<V>>> banned_edges(prev_path.size() - 1);
 
         for (const path& path : kth_path) {
             for (unsigned i = 0; i < std::min(prev_path.size(), path.size()) - 1; ++i) {
@@ -147,63 +333,90 @@ std::vector<path> yen(const std::vector<std::vector<edge>>& graph, const unsigne
                     break;
                 }
 
-                banned_edges[i].insert({ path[i], path[i + 1] });
+                banned_edges[i].insert({ static_cast<V>(path[i]), static_cast<V>(path[i + 1]) });
             }
         }
 
+        //with fewer spur tasks than threads, run them one at a time with all threads on each search
+        const bool parallelSpurs = parallelSearch && prev_path.size() - 1 < threads;
+
         //i - deviation from k-1th shortest path
-        for (unsigned i = 0; i < prev_path.size() - 1; ++i) {
-            tpool.enqueue([&, i]() {
-                std::unordered_set<unsigned> banned_vertices;
+        auto spur = [&](const unsigned i) {
+            pathWithCost<D> spurPath;
 
-                for (unsigned j = 0; j < i; ++j) {
-                    banned_vertices.insert(prev_path[j]);
-                }
+            if (parallelSpurs) {
+                std::unordered_set<V> banned_vertices(prev_path.begin(), prev_path.begin() + i);
 
-                std::function<bool(const edge&)> filter = [&](const edge& e) {
+                std::function<bool(const edgeKey<V>&)> filter = [&](const edgeKey<V>& e) {
                     return !banned_edges[i].count(e) && !banned_vertices.count(e.first) && !banned_vertices.count(e.second);
                 };
 
-                pathWithCost spurPath = dijkstra_to(graph, prev_path[i], end, filter);
+                spurPath = parallel_dijkstra_to<V, W, D>(graph, prev_path[i], end, maxWeight, *tpool, threads, filter);
+            } else {
+                //all banned edges leave the spur node, so they only matter for the first relaxation
+                std::vector<uint32_t> banned = bannedSet(graph.size());
+                std::vector<V> bannedFromSpur;
 
-                if (spurPath.getTotalCost() >= INT_MAX) {
-                    return;
+                for (unsigned j = 0; j < i; ++j) {
+                    ban(banned, prev_path[j]);
                 }
 
-                //append root to spur
-                path curr_path(prev_path.begin(), prev_path.begin() + i);
-                curr_path.insert(curr_path.end(), spurPath.pathNodes.begin(), spurPath.pathNodes.end());
+                for (const edgeKey<V>& e : banned_edges[i]) {
+                    bannedFromSpur.push_back(e.second);
+                }
 
-                {
-                    std::unique_lock<std::mutex> lock(candidates_mutex);
+                spurPath = csr_dijkstra_to<V, W, D>(csr.get(), prev_path[i], end, banned, bannedFromSpur);
+            }
 
-                    if (candidates_set.count(curr_path)) {
-                        return;
-                    }
+            if (spurPath.getTotalCost() == std::numeric_limits<D>::max()) {
+                return;
+            }
 
-                    candidates_set.insert(curr_path);
-                }
-                
-                std::vector<unsigned> cumulativeCost;
-                for (size_t j = 0; j < curr_path.size(); ++j) {
-                    cumulativeCost.push_back(j <= i ? kth_cost[curr_k - 1][j] : kth_cost[curr_k - 1][i] + spurPath.cumulativeCost[j - i]);
-                }
-                
-                {
-                    std::unique_lock<std::mutex> lock(candidates_mutex);
-                    candidate_paths.push({ curr_path, cumulativeCost });
+            //append root to spur
+            path curr_path(prev_path.begin(), prev_path.begin() + i);
+            curr_path.insert(curr_path.end(), spurPath.pathNodes.begin(), spurPath.pathNodes.end());
+
+            {
+                std::unique_lock<std::mutex> lock(candidates_mutex);
+
+                if (candidates_set.count(curr_path)) {
+                    return;
                 }
-            });
+
+                candidates_set.insert(curr_path);
+            }
+            
+            std::vector<D> cumulativeCost;
+            for (size_t j = 0; j < curr_path.size(); ++j) {
+                cumulativeCost.push_back(j <= i ? kth_cost[curr_k - 1][j] : kth_cost[curr_k - 1][i] + spurPath.cumulativeCost[j - i]);
+            }
+            
+            {
+                std::unique_lock<std::mutex> lock(candidates_mutex);
+                candidate_paths.push({ curr_path, cumulativeCost });
+            }
+        };
+
+        for (unsigned i = 0; i < prev_path.size() - 1; ++i) {
+            if (!tpool || parallelSpurs) {
+                spur(i);
+            } else {
+                tpool->enqueue([&, i]() {
+                    spur(i);
+                });
+            }
         }
 
-        tpool.wait_finished();
+        if (tpool) {
+            tpool->wait_finished();
+        }
 
         if (candidates_set.empty()) {
             break;
         }
 
         kth_path.push_back(candidate_paths.top().pathNodes);
-        kth_cost[curr_k] = candidate_paths.top().cumulativeCost;
+        kth_cost.push_back(candidate_paths.top().cumulativeCost);
 
         candidates_set.erase(kth_path[curr_k]);
         candidate_paths.pop();
@@ -212,8 +425,119 @@ std::vector<path> yen(const std::vector<std::vector<edge>>& graph, const unsigne
     return kth_path;
 }
 
+template <typename V, typename W, typename D>
+std::vector<path> yen(const graph_t<V, W>& graph, const V start,
+    const V end, const unsigned k, const unsigned threads) {
+    if (start > graph.size() - 1 || end > graph.size() - 1) {
+        throw std::invalid_argument("Provided start or end is not a vertex in the graph.");
+    }
+
+    if (k == 0) {
+        throw std::invalid_argument("Invalid K! Must be at least 1.");
+    }
+
+    std::optional<Threadpool> tpool;
+    if (threads > 1) {
+        tpool.emplace(threads);
+    }
+
+    //a single search can only use several threads through delta-stepping, which only pays off on big graphs
+    const bool parallelSearch = tpool && graph.size() >= PARALLEL_SEARCH_MIN_VERTICES;
+    const W maxWeight = parallelSearch ? maxEdgeWeight(graph) : 0;
+
+    lazyCsr<V, W> csr(graph);
+
+    pathWithCost<D> path0 = parallelSearch ? parallel_dijkstra_to<V, W, D>(graph, start, end, maxWeight, *tpool, threads)
+        : csr_dijkstra_to<V, W, D>(csr.get(), start, end, bannedSet(graph.size()), {});
+
+    if (path0.getTotalCost() == std::numeric_limits<D>::max()) {
+        return {};
+    }
+
+    return yenFrom<V, W, D>(graph, csr, path0, end, k, tpool ? &*tpool : nullptr, threads, maxWeight);
+}
+
+template <typename V, typename W, typename D>
+void yenToMany(const graph_t<V, W>& graph, const V start, const std::vector<V>& ends, const unsigned k, 
+    const unsigned threads, std::function<void(const size_t, std::vector<path>&)> onResult) {
+    if (start > graph.size() - 1) {
+        throw std::invalid_argument("Provided start is not a vertex in the graph.");
+    }
+
+    for (V end : ends) {
+        if (end > graph.size() - 1) {
+            throw std::invalid_argument("Provided end is not a vertex in the graph.");
+        }
+    }
+
+    if (k == 0) {
+        throw std::invalid_argument("Invalid K! Must be at least 1.");
+    }
+
+    if (ends.empty()) {
+        return;
+    }
+
+    const bool parallelSearch = threads > 1 && graph.size() >= PARALLEL_SEARCH_MIN_VERTICES;
+    const W maxWeight = parallelSearch ? maxEdgeWeight(graph) : 0;
+
+    lazyCsr<V, W> csr(graph);
+
+    //the first path to every target comes from the same shortest path tree
+    std::vector<V> prev;
+    std::vector<D> dist;
+
+    if (parallelSearch) {
+        Threadpool tpool(threads);
+        dist = deltaStepping<V, W, D>(graph, start, maxWeight, tpool, threads, &prev);
+    } else {
+        dist = csrDijkstra<V, W, D>(csr.get(), start, bannedSet(graph.size()), {}, prev);
+    }
+
+    //targets run side by side, splitting the threads between them
+    const unsigned targetThreads = std::min<size_t>(threads, ends.size());
+    const unsigned spurThreads = std::max<unsigned>(1, threads / targetThreads);
+    Threadpool targetPool(targetThreads);
+
+    for (size_t t = 0; t < ends.size(); ++t) {
+        targetPool.enqueue([&, t]() {
+            pathWithCost<D> path0 = buildPath(dist, prev, ends[t]);
+            std::vector<path> paths;
+
+            if (path0.getTotalCost() != std::numeric_limits<D>::max()) {
+                std::optional<Threadpool> spurPool;
+                if (spurThreads > 1) {
+                    spurPool.emplace(spurThreads);
+                }
+
+                paths = yenFrom<V, W, D>(graph, csr, path0, ends[t], k, spurPool ? &*spurPool : nullptr, spurThreads, maxWeight);
+            }
+
+            onResult(t, paths);
+        });
+    }
+
+    targetPool.wait_finished();
+}
+
+#define INSTANTIATE_YEN(V, W, D) \
+    template std::vector<D> dijkstra<V, W, D>(const graph_t<V, W>&, const V, \
+        std::vector<V>*, std::function<bool(const edgeKey<V>&)>); \
+    template std::vector<path> yen<V, W, D>(const graph_t<V, W>&, const V, const V, const unsigned, const unsigned); \
+    template void yenToMany<V, W, D>(const graph_t<V, W>&, const V, const std::vector<V>&, const unsigned, \
+        const unsigned, std::function<void(const size_t, std::vector<path>&)>);
+
+INSTANTIATE_YEN(uint16_t, uint16_t, uint32_t)
+INSTANTIATE_YEN(uint16_t, uint16_t, uint64_t)
+INSTANTIATE_YEN(uint16_t, uint32_t, uint32_t)
+INSTANTIATE_YEN(uint16_t, uint32_t, uint64_t)
+INSTANTIATE_YEN(uint32_t, uint16_t, uint32_t)
+INSTANTIATE_YEN(uint32_t, uint16_t, uint64_t)
+INSTANTIATE_YEN(uint32_t, uint32_t, uint32_t)
+INSTANTIATE_YEN(uint32_t, uint32_t, uint64_t)
+
 // Sample graph:
-// std::vector<std::vector<edge>> graph(5);
+// graph_t<unsigned, unsigned> graph(5);
 
 // graph[0].push_back({1, 10});
 // graph[0].push_back({2, 3});
@@ -232,7 +556,7 @@ std::vector<path> yen(const std::vector<std::vector<edge>>& graph, const unsigne
 // for (unsigned i = 0; i < graph.size(); i++) {
 //     std::cout << "Node " << i << ": ";
 
-//     for (edge& edge : graph[i]) {
+//     for (edge<unsigned, unsigned>& edge : graph[i]) {
 //         std::cout << "(" << edge.first << ", " << edge.second << ") ";
 //     }
 
@@ -240,7 +564,7 @@ std::vector<path> yen(const std::vector<std::vector<edge>>& graph, const unsigne
 // }
 
 // unsigned k = 5;
-// std::vector<path> paths = yen(graph, 0, 3, k);
+// std::vector<path> paths = yen<unsigned, unsigned, uint64_t>(graph, 0, 3, k);
 
 // Top 5 shortest paths:
 // Path 1: 0 2 1 3 (cost = 9)
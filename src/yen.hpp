@@ -5,11 +5,31 @@
 #include <utility>
 #include <vector>
 
-typedef std::pair<unsigned, unsigned> edge;
+// V - vertex ID type, W - edge weight type, D - accumulated distance type.
+// D must be able to hold any loopless path cost plus one edge; its maximum value is used as infinity.
+
+template <typename V, typename W>
+using edge = std::pair<V, W>;
+
+template <typename V, typename W>
+using graph_t = std::vector<std::vector<edge<V, W>>>;
+
+// (from, to) pair identifying an edge regardless of its weight
+template <typename V>
+using edgeKey = std::pair<V, V>;
+
 typedef std::vector<unsigned> path;
 
-std::vector<unsigned> dijkstra(const std::vector<std::vector<edge>>& graph, const unsigned start, 
-    std::vector<unsigned>* prev = nullptr, std::function<bool(const edge&)> filter = nullptr);
+template <typename V, typename W, typename D>
+std::vector<D> dijkstra(const graph_t<V, W>& graph, const V start,
+    std::vector<V>* prev = nullptr, std::function<bool(const edgeKey<V>&)> filter = nullptr);
+
+template <typename V, typename W, typename D>
+std::vector<path> yen(const graph_t<V, W>& graph, const V start,
+    const V end, const unsigned k, const unsigned threads = std::thread::hardware_concurrency());
 
-std::vector<path> yen(const std::vector<std::vector<edge>>& graph, const unsigned start, 
-    const unsigned end, const unsigned k, const unsigned threads = std::thread::hardware_concurrency());
\ No newline at end of file
+// K shortest paths from start to each of ends, sharing the shortest path tree from start.
+// onResult is called with the index of each target as soon as its paths are ready, possibly from several threads.
+template <typename V, typename W, typename D>
+void yenToMany(const graph_t<V, W>& graph, const V start, const std::vector<V>& ends, const unsigned k, 
+    const unsigned threads, std::function<void(const size_t, std::vector<path>&)> onResult);